@@ -0,0 +1,209 @@
+/**
+ * Author: Ethan Pinto
+ * Student Number: s4642286
+ * Program Name: unjumble
+ * File Name: batch.c
+**/
+
+#include "batch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * The read_batch function takes in an open batch file and a pointer to
+ * the query count. It parses every line of the file as a query, skipping
+ * lines that are empty or hold only whitespace.
+ * Returns an array of the parsed queries, in file order.
+ */
+BatchQuery *read_batch(FILE *batchFile, int *queryCount) {
+    int capacity = INITIAL_MATCHES;
+    BatchQuery *queries = (BatchQuery *) malloc(sizeof(BatchQuery) *
+            capacity);
+    char *line = NULL;
+    size_t lineSize = 0;
+    *queryCount = 0;
+
+    while (getline(&line, &lineSize, batchFile) >= 0) {
+        if (!line[strspn(line, QUERY_DELIMS)]) {
+            continue;
+        }
+        if (*queryCount == capacity) {
+            capacity *= 2;
+            queries = (BatchQuery *) realloc(queries, sizeof(BatchQuery) *
+                    capacity);
+        }
+        BatchQuery *batchQuery = &queries[(*queryCount)++];
+        memset(batchQuery, 0, sizeof(BatchQuery));
+        batchQuery->argStructs = create_structs();
+        batchQuery->status = parse_request(line, batchQuery->argStructs);
+        if (!batchQuery->status) {
+            prepare_query(&batchQuery->query,
+                    batchQuery->argStructs[2]->data,
+                    batchQuery->argStructs[1]->data);
+        }
+    }
+    free(line);
+    return queries;
+}
+
+/**
+ * The make_letter_lists function takes in the parsed queries and their
+ * count, and builds, for each letter of the alphabet, the list of valid
+ * queries whose letters contain that letter, or that have a blank tile to
+ * stand in for it. A word can only match the queries in the list of each
+ * of its letters, so only the shortest of those lists needs to be checked.
+ * Pattern queries and queries without letters are left out, as they are
+ * answered separately. The lists and their lengths are written to the
+ * given arrays. Returns nothing.
+ */
+void make_letter_lists(BatchQuery *queries, int queryCount,
+        int *lists[ALPHABET_SIZE], int listLengths[ALPHABET_SIZE]) {
+    for (int letter = 0; letter < ALPHABET_SIZE; letter++) {
+        lists[letter] = (int *) malloc(sizeof(int) *
+                (queryCount ? queryCount : 1));
+        listLengths[letter] = 0;
+    }
+    for (int q = 0; q < queryCount; q++) {
+        if (queries[q].status || queries[q].argStructs[PATTERN_ARG]->data ||
+                !queries[q].argStructs[2]->data) {
+            continue;
+        }
+        uint32_t mask = queries[q].query.lettersSig.mask;
+        if (queries[q].query.blanks) {
+            mask = LETTER_BITS;
+        }
+        for (int letter = 0; letter < ALPHABET_SIZE; letter++) {
+            if (mask & (1u << letter)) {
+                lists[letter][listLengths[letter]++] = q;
+            }
+        }
+    }
+}
+
+/**
+ * Takes in a batch query and the index of a word that matches it, and
+ * appends the index to the query's matches. Returns nothing.
+ */
+void add_match(BatchQuery *batchQuery, uint32_t word) {
+    if (batchQuery->matchCount == batchQuery->capacity) {
+        batchQuery->capacity = batchQuery->capacity ?
+                batchQuery->capacity * 2 : INITIAL_MATCHES;
+        batchQuery->matches = (uint32_t *) realloc(batchQuery->matches,
+                sizeof(uint32_t) * batchQuery->capacity);
+    }
+    batchQuery->matches[batchQuery->matchCount++] = word;
+}
+
+/**
+ * The scan_batch function takes in the dictionary and the parsed queries.
+ * It walks the dictionary once, and tests each word's letter counts against
+ * the histogram of every query that could contain it, collecting matches
+ * per query in dictionary order. Returns nothing.
+ */
+void scan_batch(Dict *dict, BatchQuery *queries, int queryCount) {
+    int *lists[ALPHABET_SIZE];
+    int listLengths[ALPHABET_SIZE];
+    make_letter_lists(queries, queryCount, lists, listLengths);
+
+    for (int i = 0; i < dict->wordCount; i++) {
+        uint32_t mask = dict->masks[i];
+        if (dict->lengths[i] < MIN_WORD_LEN || (mask & NON_ALPHA_BIT)) {
+            continue;
+        }
+        // Choose the letter of the word shared by the fewest queries.
+        int best = -1;
+        for (int letter = 0; letter < ALPHABET_SIZE; letter++) {
+            if ((mask & (1u << letter)) && (best < 0 ||
+                    listLengths[letter] < listLengths[best])) {
+                best = letter;
+            }
+        }
+        for (int n = 0; best >= 0 && n < listLengths[best]; n++) {
+            BatchQuery *batchQuery = &queries[lists[best][n]];
+            const Query *query = &batchQuery->query;
+            if (dict->lengths[i] > query->lettersLen ||
+                    word_fits(dict, i, &query->lettersSig,
+                    query->blanks) == -1 ||
+                    ((mask & OVERFLOW_BIT) &&
+                    exact_fit(dict_word(dict, i), query->letters) == -1) ||
+                    (query->includeBit &&
+                    has_single_letter(query->includeBit, mask) == -1)) {
+                continue;
+            }
+            add_match(batchQuery, i);
+        }
+    }
+    for (int letter = 0; letter < ALPHABET_SIZE; letter++) {
+        free(lists[letter]);
+    }
+}
+
+/**
+ * Handles "unjumble -batch queryfile [dictionary]". Every line of the
+ * query file is a query of the form accepted by the query server, and
+ * blank lines are ignored. All of the queries are answered with one pass
+ * over the dictionary, and the results are written grouped per query, in
+ * file order, each group followed by an empty line. Invalid queries are
+ * answered with the command line's error message. It takes in the command
+ * line arguments and the argument structs, and exits with 0 on success, 1
+ * on a usage error, 2 if the query file or dictionary cannot be opened and
+ * 5 if the results cannot be written.
+ */
+void batch_mode(int argc, char **argv, ArgType **argStructs) {
+    if (argc < MIN_BATCH_ARGS || argc > MAX_BATCH_ARGS) {
+        fprintf(stderr, BATCH_USAGE);
+        free_structs(argStructs);
+        exit(1);
+    }
+    argStructs[3]->data = strdup(argv[2]);
+    FILE *batchFile = fopen(argv[2], "r");
+    if (!batchFile) {
+        err_check(2, argStructs);
+    }
+    free(argStructs[3]->data);
+    argStructs[3]->data = strdup(argc == MAX_BATCH_ARGS ? argv[3] :
+            DEFAULT_DICT);
+    Dict *dict = load_dict(argStructs[3]->data);
+    if (!dict) {
+        fclose(batchFile);
+        err_check(2, argStructs);
+    }
+
+    int queryCount;
+    BatchQuery *queries = read_batch(batchFile, &queryCount);
+    fclose(batchFile);
+    scan_batch(dict, queries, queryCount);
+
+    // Write the results of each query in file order.
+    int failed = 0;
+    for (int q = 0; q < queryCount; q++) {
+        if (queries[q].status) {
+            write_request_error(queries[q].status, stdout);
+        } else if (queries[q].argStructs[PATTERN_ARG]->data ||
+                !queries[q].argStructs[2]->data) {
+            // Pattern queries are answered from the positional bitmaps, and
+            // queries without letters take every word.
+            failed |= run_query(queries[q].argStructs, dict, stdout,
+                    NULL) < 0;
+        } else {
+            int kept = rank_words(queries[q].argStructs, dict,
+                    queries[q].matches, queries[q].matchCount);
+            failed |= output_words(queries[q].argStructs, dict,
+                    queries[q].matches, kept, 0, stdout, NULL) < 0;
+        }
+        printf("\n");
+        free(queries[q].matches);
+        free_structs(queries[q].argStructs);
+    }
+    free(queries);
+    free_dict(dict);
+    failed |= fflush(stdout) != 0 || ferror(stdout);
+    if (failed) {
+        fprintf(stderr, WRITE_MESSAGE);
+        free_structs(argStructs);
+        exit(5);
+    }
+    free_structs(argStructs);
+    exit(0);
+}
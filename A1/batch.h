@@ -0,0 +1,26 @@
+#ifndef _BATCH_H
+#define _BATCH_H
+
+#include "unjumble.h"
+#include "filter.h"
+
+// Macro Definitions
+#define MIN_BATCH_ARGS 3
+#define MAX_BATCH_ARGS 4
+#define INITIAL_MATCHES 16
+#define BATCH_USAGE "Usage: unjumble -batch queryfile [dictionary]\n"
+
+// One line of a batch file, along with the words it has matched so far.
+typedef struct {
+    ArgType **argStructs;   // The parsed query line
+    int status;             // Result of parse_request (0 if valid)
+    Query query;            // The prepared letters of a valid query
+    uint32_t *matches;      // Indices of matching words, in dictionary order
+    int matchCount;         // Number of matching words
+    int capacity;           // Room in the matches array
+} BatchQuery;
+
+// Function Declarations
+void batch_mode(int argc, char **argv, ArgType **argStructs);
+
+#endif
@@ -0,0 +1,279 @@
+/**
+ * Author: Ethan Pinto
+ * Student Number: s4642286
+ * Program Name: bench
+ * File Name: bench.c
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "bench.h"
+#include "gendict.h"
+#include "../stats.h"
+
+// The phases -stats reports, followed by the whole query.
+static const char *phases[PHASE_COUNT] = {
+    "load", "filter", "sort", "output", "total"
+};
+
+// The query mix: short and long letter sets, -include, and each specifier.
+static const MixSpec mixes[MIX_COUNT] = {
+    {"short", NULL, 3, 5, 0},
+    {"long", NULL, 10, 15, 0},
+    {"include", NULL, 6, 9, 1},
+    {"alpha", "-alpha", 6, 9, 0},
+    {"len", "-len", 6, 9, 0},
+    {"longest", "-longest", 6, 9, 0},
+    {"long-alpha", "-alpha", 10, 15, 0}
+};
+
+/**
+ * The sample_word function takes in the open dictionary, its size, the
+ * random generator's state and a buffer of MAX_QUERY_LETTERS + 1 bytes.
+ * It seeks to a random place in the dictionary and copies the letters of
+ * the word after it, case folded, so queries are made from words that are
+ * really there. Returns the number of letters copied.
+ */
+int sample_word(FILE *dictFile, long dictSize, uint64_t *state,
+        char *letters) {
+    int length = 0;
+    fseek(dictFile, (long)(next_random(state) % (uint64_t)dictSize),
+            SEEK_SET);
+    int c;
+    // Skip the rest of the word the seek landed in.
+    while ((c = getc(dictFile)) != EOF && c != '\n') {
+    }
+    if (c == EOF) {
+        rewind(dictFile);
+    }
+    while ((c = getc(dictFile)) != EOF && c != '\n' &&
+            length < MAX_QUERY_LETTERS) {
+        if (isalpha(c)) {
+            letters[length++] = tolower(c);
+        }
+    }
+    letters[length] = '\0';
+    return length;
+}
+
+/**
+ * The make_letters function takes in a kind of query, the open dictionary,
+ * its size, the random generator's state, and the letters and -include
+ * letter to fill in. The letters of a random dictionary word are cut down
+ * or added to until there are as many as the kind of query asks for, then
+ * shuffled. The -include letter, if the kind has one, is one of them.
+ * Returns nothing.
+ */
+void make_letters(const MixSpec *mix, FILE *dictFile, long dictSize,
+        uint64_t *state, char *letters, char *include) {
+    int wanted = mix->minLetters + (int)(next_random(state) %
+            (uint64_t)(mix->maxLetters - mix->minLetters + 1));
+    int length = 0;
+    for (int i = 0; i < SAMPLE_TRIES && length < mix->minLetters; i++) {
+        length = sample_word(dictFile, dictSize, state, letters);
+    }
+    while (length < wanted) {
+        letters[length++] = 'a' + next_random(state) % ALPHABET_SIZE;
+    }
+    length = wanted;
+    letters[length] = '\0';
+    for (int i = length - 1; i > 0; i--) {
+        int j = next_random(state) % (i + 1);
+        char swap = letters[i];
+        letters[i] = letters[j];
+        letters[j] = swap;
+    }
+    include[0] = letters[next_random(state) % length];
+    include[1] = '\0';
+}
+
+/**
+ * The run_query function takes in the arguments of an unjumble query,
+ * with -stats among them, and an array to fill in with the seconds taken
+ * by each phase. The query is run with its output discarded, and the
+ * times of its phases are read from its standard error. The total is the
+ * wall clock time of the whole process.
+ * Returns the query's exit status, or -1 if it could not be run.
+ */
+int run_query(char **args, double *times) {
+    int fds[2];
+    if (pipe(fds) == -1) {
+        return -1;
+    }
+    double start = stats_clock();
+    pid_t pid = fork();
+    if (pid == 0) {
+        int devNull = open("/dev/null", O_WRONLY);
+        dup2(devNull, STDOUT_FILENO);
+        dup2(fds[1], STDERR_FILENO);
+        close(devNull);
+        close(fds[0]);
+        close(fds[1]);
+        execv(args[0], args);
+        _exit(99);
+    }
+    close(fds[1]);
+    if (pid < 0) {
+        close(fds[0]);
+        return -1;
+    }
+    FILE *stats = fdopen(fds[0], "r");
+    char line[STATS_LINE];
+    memset(times, 0, sizeof(double) * PHASE_COUNT);
+    while (fgets(line, sizeof(line), stats)) {
+        for (int phase = 0; phase < PHASE_TOTAL; phase++) {
+            size_t nameLength = strlen(phases[phase]);
+            if (strncmp(line, phases[phase], nameLength) == 0 &&
+                    strncmp(line + nameLength, " time: ", 7) == 0) {
+                times[phase] = atof(line + nameLength + 7);
+            }
+        }
+    }
+    fclose(stats);
+    int status;
+    waitpid(pid, &status, 0);
+    times[PHASE_TOTAL] = stats_clock() - start;
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+/**
+ * The comparison function for sorting times in ascending order.
+ */
+static int cmp_time(const void *time1, const void *time2) {
+    double difference = *(const double *)time1 - *(const double *)time2;
+    return (difference > 0) - (difference < 0);
+}
+
+/**
+ * Takes in an array of times sorted in ascending order, its length, and a
+ * percentile rank from 1 to 100. Returns the time at that rank, by the
+ * nearest rank method.
+ */
+double percentile(double *times, int count, int rank) {
+    int place = (rank * count + 99) / 100;
+    return times[place > 0 ? place - 1 : 0];
+}
+
+/**
+ * The report function takes in a kind of query, its results and the
+ * stream machine readable results are written to (or NULL). For each
+ * phase it prints the p50 and p99 latency in milliseconds, and writes one
+ * JSON object per line with the same figures in seconds, along with the
+ * throughput of the whole mix in queries per second. Returns nothing.
+ */
+void report(const MixSpec *mix, MixResult *result, FILE *json) {
+    double throughput = result->elapsed > 0 ?
+            result->queries / result->elapsed : 0;
+    printf("%-12s %8.1f q/s", mix->name, throughput);
+    for (int phase = 0; phase < PHASE_COUNT; phase++) {
+        qsort(result->times[phase], result->queries, sizeof(double),
+                cmp_time);
+        double p50 = percentile(result->times[phase], result->queries, P50);
+        double p99 = percentile(result->times[phase], result->queries, P99);
+        printf("  %s %.3f/%.3f", phases[phase], p50 * 1e3, p99 * 1e3);
+        if (json) {
+            fprintf(json, "{\"mix\": \"%s\", \"phase\": \"%s\", "
+                    "\"queries\": %d, \"failed\": %d, "
+                    "\"throughput\": %.3f, \"p50\": %.9f, "
+                    "\"p99\": %.9f}\n", mix->name, phases[phase],
+                    result->queries, result->failed, throughput, p50, p99);
+        }
+    }
+    printf(result->failed ? "  (%d failed)\n" : "\n", result->failed);
+}
+
+/**
+ * The entry point of bench, which runs the query mix against a dictionary
+ * with the given unjumble binary and reports the latency of each phase.
+ * Exits with 0 on success, 1 on a usage error, 2 if the dictionary cannot
+ * be opened and 5 if the results file cannot be written.
+ */
+int main(int argc, char **argv) {
+    int queries = DEFAULT_QUERIES;
+    uint64_t state = DEFAULT_SEED;
+    char *jsonName = NULL;
+    if (argc < 3) {
+        fprintf(stderr, BENCH_USAGE);
+        exit(1);
+    }
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "-queries") == 0 && i + 1 < argc &&
+                atoi(argv[i + 1]) > 0) {
+            queries = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-seed") == 0 && i + 1 < argc &&
+                atoi(argv[i + 1]) > 0) {
+            state = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-json") == 0 && i + 1 < argc) {
+            jsonName = argv[++i];
+        } else {
+            fprintf(stderr, BENCH_USAGE);
+            exit(1);
+        }
+    }
+    FILE *dictFile = fopen(argv[2], "r");
+    struct stat info;
+    if (!dictFile || fstat(fileno(dictFile), &info) == -1 ||
+            info.st_size == 0) {
+        fprintf(stderr, "bench: file \"%s\" can not be opened\n", argv[2]);
+        exit(2);
+    }
+    FILE *json = jsonName ? fopen(jsonName, "w") : NULL;
+    if (jsonName && !json) {
+        fprintf(stderr, "bench: file \"%s\" can not be written\n",
+                jsonName);
+        exit(5);
+    }
+
+    printf("%-12s %12s  phase p50/p99 (ms)\n", "mix", "throughput");
+    for (int m = 0; m < MIX_COUNT; m++) {
+        MixResult result;
+        memset(&result, 0, sizeof(MixResult));
+        for (int phase = 0; phase < PHASE_COUNT; phase++) {
+            result.times[phase] = (double *) malloc(sizeof(double) *
+                    queries);
+        }
+        for (int q = 0; q < queries; q++) {
+            char letters[MAX_QUERY_LETTERS + 1], include[2];
+            make_letters(&mixes[m], dictFile, info.st_size, &state,
+                    letters, include);
+            char *args[MAX_BENCH_ARGS];
+            int argCount = 0;
+            args[argCount++] = argv[1];
+            args[argCount++] = "-stats";
+            if (mixes[m].spec) {
+                args[argCount++] = (char *)mixes[m].spec;
+            }
+            if (mixes[m].include) {
+                args[argCount++] = "-include";
+                args[argCount++] = include;
+            }
+            args[argCount++] = letters;
+            args[argCount++] = argv[2];
+            args[argCount] = NULL;
+
+            double times[PHASE_COUNT];
+            int status = run_query(args, times);
+            result.failed += status != 0 && status != 10;
+            for (int phase = 0; phase < PHASE_COUNT; phase++) {
+                result.times[phase][result.queries] = times[phase];
+            }
+            result.elapsed += times[PHASE_TOTAL];
+            result.queries++;
+        }
+        report(&mixes[m], &result, json);
+        for (int phase = 0; phase < PHASE_COUNT; phase++) {
+            free(result.times[phase]);
+        }
+    }
+    if (json) {
+        fclose(json);
+    }
+    fclose(dictFile);
+    return 0;
+}
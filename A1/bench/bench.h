@@ -0,0 +1,47 @@
+#ifndef _BENCH_H
+#define _BENCH_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+// Macro Definitions
+#define PHASE_COUNT 5
+#define PHASE_TOTAL 4
+#define MIX_COUNT 7
+#define DEFAULT_QUERIES 100
+#define MAX_BENCH_ARGS 10
+#define MAX_QUERY_LETTERS 32
+#define SAMPLE_TRIES 16
+#define STATS_LINE 128
+#define P50 50
+#define P99 99
+#define BENCH_USAGE "Usage: bench unjumble dictionary [-queries n] " \
+        "[-seed n] [-json file]\n"
+
+// One kind of query in the benchmark's mix.
+typedef struct {
+    const char *name;       // Name the results are reported under
+    const char *spec;       // Specifier to pass, or NULL
+    int minLetters;         // Fewest letters in a query
+    int maxLetters;         // Most letters in a query
+    int include;            // True if the query has an -include letter
+} MixSpec;
+
+// The timings of every query of one kind, by phase.
+typedef struct {
+    double *times[PHASE_COUNT]; // Seconds taken by each query in a phase
+    int queries;                // Number of queries run
+    int failed;                 // Number of queries that exited with error
+    double elapsed;             // Total wall clock time of the queries
+} MixResult;
+
+// Function Declarations
+int sample_word(FILE *dictFile, long dictSize, uint64_t *state,
+        char *letters);
+void make_letters(const MixSpec *mix, FILE *dictFile, long dictSize,
+        uint64_t *state, char *letters, char *include);
+int run_query(char **args, double *times);
+double percentile(double *times, int count, int rank);
+void report(const MixSpec *mix, MixResult *result, FILE *json);
+
+#endif
@@ -0,0 +1,145 @@
+/**
+ * Author: Ethan Pinto
+ * Student Number: s4642286
+ * Program Name: gendict
+ * File Name: gendict.c
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "gendict.h"
+
+// Relative frequency of each letter in English text, per ten thousand.
+static const int englishLetters[ALPHABET_SIZE] = {
+    817, 149, 278, 425, 1270, 223, 202, 609, 697, 15, 77, 403, 241,
+    675, 751, 193, 10, 599, 633, 906, 276, 98, 236, 15, 197, 7
+};
+
+// Relative frequency of each word length from 0 to 15 in an English word
+// list, per thousand.
+static const int englishLengths[ENGLISH_LENGTHS] = {
+    0, 0, 5, 22, 55, 95, 130, 145, 140, 125, 100, 70, 45, 30, 20, 18
+};
+
+/**
+ * Takes in an array of weights, its length, their total and the random
+ * generator's state, and picks a position with probability proportional
+ * to its weight. Returns the position picked.
+ */
+static int pick(const int *weights, int count, long total,
+        uint64_t *state) {
+    long target = (long)(next_random(state) % (uint64_t)total);
+    for (int i = 0; i < count; i++) {
+        if (target < weights[i]) {
+            return i;
+        }
+        target -= weights[i];
+    }
+    return count - 1;
+}
+
+/**
+ * The parse_gen function takes in the command line arguments and the
+ * specification to fill in. Word lengths follow an English word list
+ * unless -len gives a range to draw them from evenly, and letters follow
+ * English text unless -letters asks for uniform letters or names a file
+ * of letter weights, in the form of an unjumble -scores file.
+ * Returns 0 if the arguments are valid and 1 otherwise.
+ */
+int parse_gen(int argc, char **argv, GenSpec *spec) {
+    char *end;
+    if (argc < 2 || !isdigit(argv[1][0])) {
+        return 1;
+    }
+    spec->wordCount = strtol(argv[1], &end, 10);
+    if (*end != '\0' || spec->wordCount < MIN_DICT_WORDS ||
+            spec->wordCount > MAX_DICT_WORDS) {
+        return 1;
+    }
+    memset(spec->lengthWeights, 0, sizeof(spec->lengthWeights));
+    memcpy(spec->lengthWeights, englishLengths, sizeof(englishLengths));
+    memcpy(spec->letterWeights, englishLetters, sizeof(englishLetters));
+    spec->seed = DEFAULT_SEED;
+
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "-len") == 0 && i + 2 < argc) {
+            int min = atoi(argv[i + 1]), max = atoi(argv[i + 2]);
+            if (min < 1 || max < min || max > MAX_GEN_LENGTH) {
+                return 1;
+            }
+            memset(spec->lengthWeights, 0, sizeof(spec->lengthWeights));
+            for (int length = min; length <= max; length++) {
+                spec->lengthWeights[length] = 1;
+            }
+            i += 2;
+        } else if (strcmp(argv[i], "-letters") == 0 && i + 1 < argc) {
+            Ranking weights;
+            i++;
+            if (strcmp(argv[i], "uniform") == 0) {
+                for (int letter = 0; letter < ALPHABET_SIZE; letter++) {
+                    spec->letterWeights[letter] = 1;
+                }
+            } else if (strcmp(argv[i], "english") != 0) {
+                if (read_scores(argv[i], &weights) == -1) {
+                    return 1;
+                }
+                memcpy(spec->letterWeights, weights.values,
+                        sizeof(weights.values));
+            }
+        } else if (strcmp(argv[i], "-seed") == 0 && i + 1 < argc &&
+                isdigit(argv[i + 1][0])) {
+            spec->seed = strtoull(argv[++i], NULL, 10);
+        } else {
+            return 1;
+        }
+    }
+    long letterTotal = 0;
+    for (int letter = 0; letter < ALPHABET_SIZE; letter++) {
+        letterTotal += spec->letterWeights[letter];
+    }
+    return letterTotal > 0 ? 0 : 1;
+}
+
+/**
+ * Takes in the specification of a dictionary and the output stream, and
+ * writes that many random words, one per line. Returns nothing.
+ */
+void write_dict(const GenSpec *spec, FILE *output) {
+    long lengthTotal = 0, letterTotal = 0;
+    for (int length = 0; length <= MAX_GEN_LENGTH; length++) {
+        lengthTotal += spec->lengthWeights[length];
+    }
+    for (int letter = 0; letter < ALPHABET_SIZE; letter++) {
+        letterTotal += spec->letterWeights[letter];
+    }
+    // A zero state would stay zero forever.
+    uint64_t state = spec->seed ? spec->seed : DEFAULT_SEED;
+    char word[MAX_GEN_LENGTH + 2];
+    for (long i = 0; i < spec->wordCount; i++) {
+        int length = pick(spec->lengthWeights, MAX_GEN_LENGTH + 1,
+                lengthTotal, &state);
+        for (int j = 0; j < length; j++) {
+            word[j] = 'a' + pick(spec->letterWeights, ALPHABET_SIZE,
+                    letterTotal, &state);
+        }
+        word[length] = '\n';
+        fwrite(word, 1, length + 1, output);
+    }
+}
+
+/**
+ * The entry point of gendict, which writes a synthetic dictionary for
+ * benchmarking unjumble to standard output. Exits with 0 on success and 1
+ * on a usage error.
+ */
+int main(int argc, char **argv) {
+    GenSpec spec;
+    if (parse_gen(argc, argv, &spec)) {
+        fprintf(stderr, GENDICT_USAGE);
+        exit(1);
+    }
+    write_dict(&spec, stdout);
+    return 0;
+}
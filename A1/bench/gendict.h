@@ -0,0 +1,42 @@
+#ifndef _GENDICT_H
+#define _GENDICT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "../top.h"
+
+// Macro Definitions
+#define MIN_DICT_WORDS 1
+#define MAX_DICT_WORDS 100000000L
+#define MAX_GEN_LENGTH 64
+#define ENGLISH_LENGTHS 16
+#define DEFAULT_SEED 1
+#define GENDICT_USAGE "Usage: gendict words [-len min max] " \
+        "[-letters english|uniform|file] [-seed n]\n"
+
+// How the words of a synthetic dictionary are drawn. Each length and
+// letter is picked with probability proportional to its weight.
+typedef struct {
+    long wordCount;                     // Number of words to write
+    int lengthWeights[MAX_GEN_LENGTH + 1];  // Weight of each word length
+    int letterWeights[ALPHABET_SIZE];   // Weight of each letter
+    uint64_t seed;                      // Seed of the random generator
+} GenSpec;
+
+// Function Declarations
+int parse_gen(int argc, char **argv, GenSpec *spec);
+void write_dict(const GenSpec *spec, FILE *output);
+
+/**
+ * Takes in the state of a xorshift64* generator, advances it and returns
+ * the next random number. The sequence depends only on the seed, so the
+ * same dictionary and queries are made on every machine.
+ */
+static inline uint64_t next_random(uint64_t *state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545f4914f6cdd1dull;
+}
+
+#endif
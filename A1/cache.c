@@ -0,0 +1,386 @@
+/**
+ * Author: Ethan Pinto
+ * Student Number: s4642286
+ * Program Name: unjumble
+ * File Name: cache.c
+**/
+
+#include "cache.h"
+#include "group.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+/**
+ * Takes in a null terminated key and returns its 64-bit FNV-1a hash.
+ */
+uint64_t hash_key(const char *key) {
+    uint64_t hash = HASH_SEED;
+    for (; *key; key++) {
+        hash = (hash ^ (unsigned char)*key) * HASH_PRIME;
+    }
+    return hash;
+}
+
+/**
+ * Creates an empty result cache.
+ * Returns the new cache, or NULL if memory could not be allocated.
+ */
+ResultCache *new_cache(void) {
+    ResultCache *cache = (ResultCache *) calloc(1, sizeof(ResultCache));
+    if (cache) {
+        pthread_mutex_init(&cache->lock, NULL);
+    }
+    return cache;
+}
+
+/**
+ * Takes in a cache and one of its entries, and removes the entry from the
+ * list of entries in order of use. Returns nothing.
+ */
+static void unlink_entry(ResultCache *cache, CacheEntry *entry) {
+    if (entry->newer) {
+        entry->newer->older = entry->older;
+    } else {
+        cache->newest = entry->older;
+    }
+    if (entry->older) {
+        entry->older->newer = entry->newer;
+    } else {
+        cache->oldest = entry->newer;
+    }
+}
+
+/**
+ * Takes in a cache and an entry that is not in the list of entries in
+ * order of use, and puts it at the most recently used end.
+ * Returns nothing.
+ */
+static void push_newest(ResultCache *cache, CacheEntry *entry) {
+    entry->newer = NULL;
+    entry->older = cache->newest;
+    if (cache->newest) {
+        cache->newest->newer = entry;
+    } else {
+        cache->oldest = entry;
+    }
+    cache->newest = entry;
+}
+
+/**
+ * Takes in a cache and removes and frees its least recently used entry.
+ * Returns nothing.
+ */
+static void drop_oldest(ResultCache *cache) {
+    CacheEntry *entry = cache->oldest;
+    unlink_entry(cache, entry);
+    CacheEntry **link = &cache->buckets[entry->hash % CACHE_BUCKETS];
+    while (*link != entry) {
+        link = &(*link)->chain;
+    }
+    *link = entry->chain;
+    cache->wordTotal -= entry->wordCount;
+    free(entry->key);
+    free(entry->words);
+    free(entry);
+}
+
+/**
+ * The cache_find function takes in a cache, the canonical key of a query
+ * and a pointer to the number of words. If the query's results are in the
+ * cache, they become the most recently used, and a copy of them is
+ * returned with their number written to wordCount. Returns NULL if the
+ * query is not in the cache.
+ */
+uint32_t *cache_find(ResultCache *cache, const char *key, int *wordCount) {
+    uint64_t hash = hash_key(key);
+    uint32_t *words = NULL;
+    pthread_mutex_lock(&cache->lock);
+    for (CacheEntry *entry = cache->buckets[hash % CACHE_BUCKETS]; entry;
+            entry = entry->chain) {
+        if (entry->hash == hash && strcmp(entry->key, key) == 0) {
+            unlink_entry(cache, entry);
+            push_newest(cache, entry);
+            words = (uint32_t *) malloc(sizeof(uint32_t) *
+                    (entry->wordCount ? entry->wordCount : 1));
+            if (words) {
+                memcpy(words, entry->words,
+                        sizeof(uint32_t) * entry->wordCount);
+                *wordCount = entry->wordCount;
+            }
+            break;
+        }
+    }
+    pthread_mutex_unlock(&cache->lock);
+    return words;
+}
+
+/**
+ * The cache_store function takes in a cache, the canonical key of a query
+ * that is not in the cache, and its ordered results. A copy of the results
+ * is added as the most recently used entry, and the least recently used
+ * entries are dropped until the cache is within its budget. Results too
+ * large to be worth keeping are not added. Returns nothing.
+ */
+void cache_store(ResultCache *cache, const char *key, const uint32_t *words,
+        int wordCount) {
+    if (wordCount > CACHE_WORD_BUDGET / CACHE_MAX_SHARE) {
+        return;
+    }
+    CacheEntry *entry = (CacheEntry *) malloc(sizeof(CacheEntry));
+    uint32_t *copy = (uint32_t *) malloc(sizeof(uint32_t) *
+            (wordCount ? wordCount : 1));
+    char *keyCopy = strdup(key);
+    if (!entry || !copy || !keyCopy) {
+        free(entry);
+        free(copy);
+        free(keyCopy);
+        return;
+    }
+    memcpy(copy, words, sizeof(uint32_t) * wordCount);
+    entry->key = keyCopy;
+    entry->hash = hash_key(key);
+    entry->words = copy;
+    entry->wordCount = wordCount;
+
+    pthread_mutex_lock(&cache->lock);
+    // Another thread may have stored the same query meanwhile.
+    for (CacheEntry *other = cache->buckets[entry->hash % CACHE_BUCKETS];
+            other; other = other->chain) {
+        if (other->hash == entry->hash && strcmp(other->key, key) == 0) {
+            pthread_mutex_unlock(&cache->lock);
+            free(keyCopy);
+            free(copy);
+            free(entry);
+            return;
+        }
+    }
+    entry->chain = cache->buckets[entry->hash % CACHE_BUCKETS];
+    cache->buckets[entry->hash % CACHE_BUCKETS] = entry;
+    push_newest(cache, entry);
+    cache->wordTotal += wordCount;
+    while (cache->wordTotal > CACHE_WORD_BUDGET) {
+        drop_oldest(cache);
+    }
+    pthread_mutex_unlock(&cache->lock);
+}
+
+/**
+ * Takes in a cache (or NULL) and frees it and every entry in it.
+ * Returns nothing.
+ */
+void free_cache(ResultCache *cache) {
+    if (!cache) {
+        return;
+    }
+    while (cache->oldest) {
+        drop_oldest(cache);
+    }
+    pthread_mutex_destroy(&cache->lock);
+    free(cache);
+}
+
+/**
+ * Takes in a cache directory and the key of a query, and returns the name
+ * of the file the query's output is kept in, which the caller frees.
+ */
+static char *cache_file(const char *dir, const char *key) {
+    char *name = (char *) malloc(strlen(dir) + CACHE_NAME_LEN + 2);
+    sprintf(name, "%s/%016llx", dir, (unsigned long long)hash_key(key));
+    return name;
+}
+
+/**
+ * Takes in two streams and copies everything left in the first to the
+ * second, flushing it once done. Returns the number of bytes copied, or -1
+ * if the second stream could not be written.
+ */
+static long copy_stream(FILE *input, FILE *output) {
+    char buffer[CACHE_COPY_SIZE];
+    size_t got;
+    long total = 0;
+    while ((got = fread(buffer, 1, sizeof(buffer), input)) > 0) {
+        if (fwrite(buffer, 1, got, output) != got) {
+            return -1;
+        }
+        total += got;
+    }
+    return fflush(output) == 0 && !ferror(output) ? total : -1;
+}
+
+/**
+ * The cache_read function takes in a cache directory, the key of a query
+ * and the output stream. A cache file starts with the key of the query
+ * whose output it holds, on a line of its own, so a file for another query
+ * with the same hash is never used. If the query's output is in the
+ * directory, it is copied to the output stream.
+ * Returns the number of bytes copied, CACHE_MISSING if the output is not
+ * cached, or CACHE_WRITE_FAILED if it could not be written to the stream.
+ */
+long cache_read(const char *dir, const char *key, FILE *output) {
+    char *name = cache_file(dir, key);
+    FILE *cached = fopen(name, "r");
+    free(name);
+    if (!cached) {
+        return -1;
+    }
+    char *line = NULL;
+    size_t lineSize = 0;
+    ssize_t length = getline(&line, &lineSize, cached);
+    long copied = CACHE_MISSING;
+    if (length > 0 && line[length - 1] == '\n') {
+        line[length - 1] = '\0';
+        if (strcmp(line, key) == 0) {
+            copied = copy_stream(cached, output);
+            copied = copied < 0 ? CACHE_WRITE_FAILED : copied;
+            // Mark the file as recently used, so it is evicted last.
+            futimens(fileno(cached), NULL);
+        }
+    }
+    free(line);
+    fclose(cached);
+    return copied;
+}
+
+/**
+ * The cache_create function takes in a cache directory, the key of a
+ * query, and a pointer to the name of a temporary file. A temporary file
+ * is made in the directory with the key as its first line, for the
+ * query's output to be written to.
+ * Returns the open file with its name written to tempName, or NULL if the
+ * file could not be made.
+ */
+FILE *cache_create(const char *dir, const char *key, char **tempName) {
+    *tempName = (char *) malloc(strlen(dir) + strlen(CACHE_TEMP_NAME) + 1);
+    sprintf(*tempName, "%s%s", dir, CACHE_TEMP_NAME);
+    int fd = mkstemp(*tempName);
+    FILE *capture = fd < 0 ? NULL : fdopen(fd, "w+");
+    if (!capture) {
+        if (fd >= 0) {
+            close(fd);
+            unlink(*tempName);
+        }
+        free(*tempName);
+        *tempName = NULL;
+        return NULL;
+    }
+    fprintf(capture, "%s\n", key);
+    fflush(capture);
+    return capture;
+}
+
+/**
+ * The comparison function used to order cache files for eviction. It
+ * takes in two cache files, and orders them from least to most recently
+ * used.
+ */
+static int cmp_used(const void *file1, const void *file2) {
+    const struct timespec *used1 = &((const CacheFile *)file1)->used;
+    const struct timespec *used2 = &((const CacheFile *)file2)->used;
+    if (used1->tv_sec != used2->tv_sec) {
+        return used1->tv_sec < used2->tv_sec ? -1 : 1;
+    }
+    return used1->tv_nsec < used2->tv_nsec ? -1 :
+            used1->tv_nsec > used2->tv_nsec;
+}
+
+/**
+ * The trim_cache function takes in a cache directory, and removes the
+ * least recently used cache files until those left hold no more than
+ * CACHE_DISK_BUDGET bytes. Only files named like cache files are counted
+ * or removed, and a file another process removes first is skipped.
+ * Returns nothing.
+ */
+static void trim_cache(const char *dir) {
+    DIR *entries = opendir(dir);
+    if (!entries) {
+        return;
+    }
+    CacheFile *files = NULL;
+    int fileCount = 0;
+    int capacity = 0;
+    long total = 0;
+    struct dirent *entry;
+    while ((entry = readdir(entries))) {
+        if (strlen(entry->d_name) != CACHE_NAME_LEN ||
+                strspn(entry->d_name, CACHE_HEX_DIGITS) != CACHE_NAME_LEN) {
+            continue;
+        }
+        char *name = (char *) malloc(strlen(dir) + CACHE_NAME_LEN + 2);
+        sprintf(name, "%s/%s", dir, entry->d_name);
+        struct stat fileInfo;
+        if (stat(name, &fileInfo) != 0) {
+            free(name);
+            continue;
+        }
+        if (fileCount == capacity) {
+            capacity = capacity ? capacity * 2 : CACHE_BUCKETS;
+            files = (CacheFile *) realloc(files, sizeof(CacheFile) *
+                    capacity);
+        }
+        files[fileCount].name = name;
+        files[fileCount].size = fileInfo.st_size;
+        files[fileCount++].used = fileInfo.st_mtim;
+        total += fileInfo.st_size;
+    }
+    closedir(entries);
+
+    if (total > CACHE_DISK_BUDGET) {
+        qsort(files, fileCount, sizeof(CacheFile), cmp_used);
+        for (int i = 0; i < fileCount && total > CACHE_DISK_BUDGET; i++) {
+            unlink(files[i].name);
+            total -= files[i].size;
+        }
+    }
+    for (int i = 0; i < fileCount; i++) {
+        free(files[i].name);
+    }
+    free(files);
+}
+
+/**
+ * The cache_commit function takes in a file made by cache_create that a
+ * query's output has been written to, its name, the cache directory, the
+ * key of the query and the output stream. The query's output is copied to
+ * the output stream, and the file is renamed into place, so other
+ * processes only ever see complete cache files. If the output could not
+ * be written in full, the file is removed instead. Once a file is added,
+ * the least recently used files are evicted to keep the directory within
+ * CACHE_DISK_BUDGET bytes. The file is kept even if the output stream
+ * cannot be written, as it holds the query's complete output.
+ * Returns the number of bytes of output, or -1 if the output stream could
+ * not be written.
+ */
+long cache_commit(FILE *capture, char *tempName, const char *dir,
+        const char *key, FILE *output) {
+    fflush(capture);
+    int failed = ferror(capture);
+    fseek(capture, strlen(key) + 1, SEEK_SET);
+    long copied = copy_stream(capture, output);
+    if (fclose(capture) != 0 || failed) {
+        unlink(tempName);
+    } else {
+        char *name = cache_file(dir, key);
+        if (rename(tempName, name) != 0) {
+            unlink(tempName);
+        } else {
+            trim_cache(dir);
+        }
+        free(name);
+    }
+    free(tempName);
+    return copied;
+}
+
+/**
+ * Takes in a file made by cache_create and its name, and removes the file
+ * without caching it, when the query's output could not be made.
+ * Returns nothing.
+ */
+void cache_abandon(FILE *capture, char *tempName) {
+    fclose(capture);
+    unlink(tempName);
+    free(tempName);
+}
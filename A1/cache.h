@@ -0,0 +1,66 @@
+#ifndef _CACHE_H
+#define _CACHE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+#include "dict.h"
+
+// Macro Definitions
+#define CACHE_BUCKETS 4096
+#define CACHE_WORD_BUDGET (1 << 24)
+#define CACHE_MAX_SHARE 4
+#define CACHE_NAME_LEN 16
+#define CACHE_TEMP_NAME "/.unjumble-XXXXXX"
+#define CACHE_COPY_SIZE 65536
+#define CACHE_DISK_BUDGET (64L << 20)
+#define CACHE_HEX_DIGITS "0123456789abcdef"
+#define CACHE_MISSING -1
+#define CACHE_WRITE_FAILED -2
+
+// The ordered results of one query, kept in a dictionary's cache.
+typedef struct CacheEntry {
+    char *key;                  // The query's canonical key
+    uint64_t hash;              // Hash of the key
+    uint32_t *words;            // The ordered matching word indices
+    int wordCount;              // Number of matching words
+    struct CacheEntry *chain;   // Next entry in the same bucket
+    struct CacheEntry *newer;   // Entry used next most recently, or NULL
+    struct CacheEntry *older;   // Entry used next least recently, or NULL
+} CacheEntry;
+
+// The results of recent queries against a dictionary, so queries that
+// differ only in the order of their letters are answered once. The least
+// recently used results are dropped once the entries hold more than
+// CACHE_WORD_BUDGET word indices in total. It is shared by every thread
+// querying the dictionary.
+struct ResultCache {
+    pthread_mutex_t lock;       // Held while the cache is used
+    CacheEntry *buckets[CACHE_BUCKETS];     // Entries by key hash
+    CacheEntry *newest;         // Most recently used entry
+    CacheEntry *oldest;         // Least recently used entry
+    long wordTotal;             // Word indices held by every entry
+};
+
+// A file in a -cache directory, considered for eviction.
+typedef struct {
+    char *name;                 // Path of the file
+    long size;                  // Size of the file in bytes
+    struct timespec used;       // When the file was last written or read
+} CacheFile;
+
+// Function Declarations
+uint64_t hash_key(const char *key);
+ResultCache *new_cache(void);
+uint32_t *cache_find(ResultCache *cache, const char *key, int *wordCount);
+void cache_store(ResultCache *cache, const char *key, const uint32_t *words,
+        int wordCount);
+void free_cache(ResultCache *cache);
+long cache_read(const char *dir, const char *key, FILE *output);
+FILE *cache_create(const char *dir, const char *key, char **tempName);
+long cache_commit(FILE *capture, char *tempName, const char *dir,
+        const char *key, FILE *output);
+void cache_abandon(FILE *capture, char *tempName);
+
+#endif
@@ -0,0 +1,746 @@
+/**
+ * Author: Ethan Pinto
+ * Student Number: s4642286
+ * Program Name: unjumble
+ * File Name: dawg.c
+**/
+
+#define _GNU_SOURCE
+#include "dawg.h"
+#include "filter.h"
+#include "index.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* CONSTRUCTION FUNCTIONS */
+
+/**
+ * Takes in the DAWG builder and adds a new node with no edges.
+ * Returns the id of the new node.
+ */
+static int new_node(DawgBuilder *builder) {
+    if (builder->nodeCount == builder->nodeCap) {
+        builder->nodeCap *= 2;
+        builder->nodes = (BuildNode *) realloc(builder->nodes,
+                sizeof(BuildNode) * builder->nodeCap);
+    }
+    BuildNode *node = &builder->nodes[builder->nodeCount];
+    memset(node, 0, sizeof(BuildNode));
+    return builder->nodeCount++;
+}
+
+/**
+ * Takes in the DAWG builder, a node, a label and the node the edge should
+ * lead to, and appends the edge to the node. Returns nothing.
+ */
+static void add_edge(DawgBuilder *builder, int from, unsigned char label,
+        int target) {
+    BuildNode *node = &builder->nodes[from];
+    if (node->edgeCount == node->edgeCap) {
+        node->edgeCap = node->edgeCap ? node->edgeCap * 2 : 1;
+        node->edges = (BuildEdge *) realloc(node->edges,
+                sizeof(BuildEdge) * node->edgeCap);
+    }
+    node->edges[node->edgeCount].label = label;
+    node->edges[node->edgeCount].target = target;
+    node->edgeCount++;
+}
+
+/**
+ * Takes in a node and returns a hash of its final flag and its edges, so
+ * that equivalent nodes hash to the same value.
+ */
+static uint32_t node_hash(const BuildNode *node) {
+    uint32_t hash = 2166136261u ^ (uint32_t)node->final;
+    for (int i = 0; i < node->edgeCount; i++) {
+        hash = (hash ^ node->edges[i].label) * 16777619u;
+        hash = (hash ^ (uint32_t)node->edges[i].target) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * Takes in two nodes and returns 1 if they are equivalent (same final flag
+ * and the same labelled edges to the same nodes), and 0 otherwise.
+ */
+static int node_equal(const BuildNode *node1, const BuildNode *node2) {
+    if (node1->final != node2->final ||
+            node1->edgeCount != node2->edgeCount) {
+        return 0;
+    }
+    for (int i = 0; i < node1->edgeCount; i++) {
+        if (node1->edges[i].label != node2->edges[i].label ||
+                node1->edges[i].target != node2->edges[i].target) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Takes in the DAWG builder and grows its registry to twice the size,
+ * rehashing every registered node. Returns nothing.
+ */
+static void grow_registry(DawgBuilder *builder) {
+    int *old = builder->registry;
+    int oldCap = builder->registryCap;
+    builder->registryCap *= 2;
+    builder->registry = (int *) malloc(sizeof(int) * builder->registryCap);
+    memset(builder->registry, -1, sizeof(int) * builder->registryCap);
+
+    for (int i = 0; i < oldCap; i++) {
+        if (old[i] < 0) {
+            continue;
+        }
+        uint32_t slot = node_hash(&builder->nodes[old[i]]) &
+                (builder->registryCap - 1);
+        while (builder->registry[slot] >= 0) {
+            slot = (slot + 1) & (builder->registryCap - 1);
+        }
+        builder->registry[slot] = old[i];
+    }
+    free(old);
+}
+
+/**
+ * Takes in the DAWG builder and a node whose edges are complete. If an
+ * equivalent node has already been registered, that node is returned.
+ * Otherwise the node is registered and returned itself.
+ */
+static int register_node(DawgBuilder *builder, int id) {
+    if (2 * (builder->registryCount + 1) > builder->registryCap) {
+        grow_registry(builder);
+    }
+    uint32_t slot = node_hash(&builder->nodes[id]) &
+            (builder->registryCap - 1);
+    while (builder->registry[slot] >= 0) {
+        int other = builder->registry[slot];
+        if (node_equal(&builder->nodes[other], &builder->nodes[id])) {
+            return other;
+        }
+        slot = (slot + 1) & (builder->registryCap - 1);
+    }
+    builder->registry[slot] = id;
+    builder->registryCount++;
+    return id;
+}
+
+/**
+ * Takes in the DAWG builder and a depth. Every unchecked node deeper than
+ * the depth is replaced by an equivalent registered node if one exists, or
+ * registered itself. Replaced nodes are left unreachable. Returns nothing.
+ */
+static void minimise(DawgBuilder *builder, int depth) {
+    while (builder->uncheckedCount > depth) {
+        int index = builder->uncheckedCount - 1;
+        int child = builder->unchecked[index];
+        int parent = index ? builder->unchecked[index - 1] : DAWG_ROOT;
+        int existing = register_node(builder, child);
+
+        if (existing != child) {
+            // The child is always the most recent edge of its parent.
+            BuildNode *parentNode = &builder->nodes[parent];
+            parentNode->edges[parentNode->edgeCount - 1].target = existing;
+            free(builder->nodes[child].edges);
+            builder->nodes[child].edges = NULL;
+            builder->nodes[child].edgeCount = 0;
+        }
+        builder->uncheckedCount--;
+    }
+}
+
+/**
+ * Takes in the DAWG builder, a word, and the length of the prefix it
+ * shares with the previously added word. Words must be added in
+ * increasing byte order. Returns nothing.
+ */
+static void add_word(DawgBuilder *builder, const char *word, int prefixLen) {
+    minimise(builder, prefixLen);
+    int node = builder->uncheckedCount ?
+            builder->unchecked[builder->uncheckedCount - 1] : DAWG_ROOT;
+
+    // Add the rest of the word as a new chain of nodes.
+    for (int i = prefixLen; word[i]; i++) {
+        int next = new_node(builder);
+        add_edge(builder, node, (unsigned char)word[i], next);
+        if (builder->uncheckedCount == builder->uncheckedCap) {
+            builder->uncheckedCap *= 2;
+            builder->unchecked = (int *) realloc(builder->unchecked,
+                    sizeof(int) * builder->uncheckedCap);
+        }
+        builder->unchecked[builder->uncheckedCount++] = next;
+        node = next;
+    }
+    builder->nodes[node].final = 1;
+}
+
+/**
+ * The comparison function used to order word indices for construction.
+ * It takes in two word indices and the dictionary, and orders the words by
+ * byte value, with repeated words ordered by their line in the dictionary.
+ */
+static int cmp_index_bytes(const void *index1, const void *index2,
+        void *dict) {
+    uint32_t line1 = *(const uint32_t *)index1;
+    uint32_t line2 = *(const uint32_t *)index2;
+    int result = strcmp(dict_word(dict, line1), dict_word(dict, line2));
+    if (result) {
+        return result;
+    }
+    return line1 < line2 ? -1 : line1 > line2;
+}
+
+/**
+ * Takes in the builder's nodes, the array of word counts (-1 where not yet
+ * known) and a node id. Returns the number of words that end at or below
+ * the node, filling in the counts of every node below it.
+ */
+static uint32_t count_below(const BuildNode *nodes, int64_t *counts, int id) {
+    if (counts[id] < 0) {
+        int64_t total = nodes[id].final;
+        for (int i = 0; i < nodes[id].edgeCount; i++) {
+            total += count_below(nodes, counts, nodes[id].edges[i].target);
+        }
+        counts[id] = total;
+    }
+    return (uint32_t)counts[id];
+}
+
+/* SERIALISATION FUNCTIONS */
+
+/**
+ * Takes in an output file, a section of data and its size, and the
+ * current write position. Writes the section padded to DAWG_ALIGN bytes,
+ * advancing the position. Returns 0 on success and -1 on failure.
+ */
+static int write_padded(FILE *out, const void *data, uint64_t size,
+        uint64_t *position) {
+    static const char padding[DAWG_ALIGN] = {0};
+    uint64_t padded = (size + DAWG_ALIGN - 1) / DAWG_ALIGN * DAWG_ALIGN;
+
+    if ((size && fwrite(data, 1, size, out) != size) ||
+            fwrite(padding, 1, padded - size, out) != padded - size) {
+        return -1;
+    }
+    *position += padded;
+    return 0;
+}
+
+/**
+ * The write_dawg function takes in the finished builder, the rank tables
+ * and the name of the output file. Reachable nodes are renumbered in
+ * breadth first order from the root, their edges are laid out together
+ * and annotated with rank offsets, and the result is written beside the
+ * file and renamed over it, so a failed build never leaves a broken DAWG.
+ * Returns 0 on success and 5 if the file cannot be written.
+ */
+static int write_dawg(DawgBuilder *builder, DawgHeader *header,
+        uint32_t *posStart, uint32_t *positions, const char *dawgName) {
+    int64_t *counts = (int64_t *) malloc(sizeof(int64_t) *
+            builder->nodeCount);
+    int *newId = (int *) malloc(sizeof(int) * builder->nodeCount);
+    int *queue = (int *) malloc(sizeof(int) * builder->nodeCount);
+    for (int i = 0; i < builder->nodeCount; i++) {
+        counts[i] = -1;
+        newId[i] = -1;
+    }
+    count_below(builder->nodes, counts, DAWG_ROOT);
+
+    // Number the reachable nodes in breadth first order.
+    int queued = 0;
+    uint32_t edgeTotal = 0;
+    newId[DAWG_ROOT] = queued;
+    queue[queued++] = DAWG_ROOT;
+    for (int head = 0; head < queued; head++) {
+        const BuildNode *node = &builder->nodes[queue[head]];
+        edgeTotal += node->edgeCount;
+        for (int i = 0; i < node->edgeCount; i++) {
+            if (newId[node->edges[i].target] < 0) {
+                newId[node->edges[i].target] = queued;
+                queue[queued++] = node->edges[i].target;
+            }
+        }
+    }
+
+    DawgNode *nodes = (DawgNode *) calloc(queued, sizeof(DawgNode));
+    DawgEdge *edges = (DawgEdge *) calloc(edgeTotal ? edgeTotal : 1,
+            sizeof(DawgEdge));
+    uint32_t edgeIndex = 0;
+    for (int n = 0; n < queued; n++) {
+        const BuildNode *node = &builder->nodes[queue[n]];
+        uint32_t rank = node->final;
+        nodes[n].firstEdge = edgeIndex;
+        nodes[n].edgeCount = node->edgeCount;
+        nodes[n].final = node->final;
+        for (int i = 0; i < node->edgeCount; i++) {
+            edges[edgeIndex].label = node->edges[i].label;
+            edges[edgeIndex].target = newId[node->edges[i].target];
+            edges[edgeIndex].rankOffset = rank;
+            rank += counts[node->edges[i].target];
+            edgeIndex++;
+        }
+    }
+    header->nodeCount = queued;
+    header->edgeCount = edgeTotal;
+
+    int status = 5;
+    char *tempName;
+    FILE *out = create_replacement(dawgName, &tempName);
+    if (out) {
+        uint64_t position = sizeof(DawgHeader);
+        int ok = fwrite(header, sizeof(DawgHeader), 1, out) == 1;
+        header->nodesOffset = position;
+        ok = ok && !write_padded(out, nodes, sizeof(DawgNode) * queued,
+                &position);
+        header->edgesOffset = position;
+        ok = ok && !write_padded(out, edges, sizeof(DawgEdge) * edgeTotal,
+                &position);
+        header->posStartOffset = position;
+        ok = ok && !write_padded(out, posStart,
+                sizeof(uint32_t) * (header->wordCount + 1), &position);
+        header->positionsOffset = position;
+        ok = ok && !write_padded(out, positions,
+                sizeof(uint32_t) * header->lineCount, &position);
+        header->fileSize = position;
+        ok = ok && fseek(out, 0, SEEK_SET) == 0 &&
+                fwrite(header, sizeof(DawgHeader), 1, out) == 1;
+        ok = commit_replacement(out, tempName, dawgName, ok);
+        status = ok ? 0 : 5;
+    }
+    free(counts);
+    free(newId);
+    free(queue);
+    free(nodes);
+    free(edges);
+    return status;
+}
+
+/**
+ * The build_dawg function takes in the name of a dictionary (text or
+ * compiled index) and the name of the file to create. Every word that
+ * could ever be an answer (at least MIN_WORD_LEN letters and nothing
+ * else) is added to a minimal DAWG, along with the dictionary lines each
+ * distinct word came from so results can be given in dictionary order.
+ * Returns 0 on success, 2 if the dictionary cannot be read, and 5 if the
+ * DAWG cannot be written.
+ */
+int build_dawg(const char *dictName, const char *dawgName) {
+    Dict *dict = load_dict(dictName);
+    if (!dict) {
+        return 2;
+    }
+
+    // Sort the words that can ever match by their bytes.
+    uint32_t *lines = (uint32_t *) malloc(sizeof(uint32_t) *
+            (dict->wordCount ? dict->wordCount : 1));
+    uint32_t lineCount = 0;
+    for (int i = 0; i < dict->wordCount; i++) {
+        if (dict->lengths[i] >= MIN_WORD_LEN &&
+                !(dict->masks[i] & NON_ALPHA_BIT)) {
+            lines[lineCount++] = i;
+        }
+    }
+    qsort_r(lines, lineCount, sizeof(uint32_t), cmp_index_bytes, dict);
+
+    DawgBuilder builder;
+    memset(&builder, 0, sizeof(DawgBuilder));
+    builder.nodeCap = INITIAL_NODES;
+    builder.nodes = (BuildNode *) malloc(sizeof(BuildNode) * INITIAL_NODES);
+    builder.registryCap = INITIAL_REGISTER;
+    builder.registry = (int *) malloc(sizeof(int) * INITIAL_REGISTER);
+    memset(builder.registry, -1, sizeof(int) * INITIAL_REGISTER);
+    builder.uncheckedCap = INITIAL_NODES;
+    builder.unchecked = (int *) malloc(sizeof(int) * INITIAL_NODES);
+    new_node(&builder);
+
+    // Add each distinct word, recording which lines it came from.
+    uint32_t *posStart = (uint32_t *) malloc(sizeof(uint32_t) *
+            (lineCount + 1));
+    uint32_t wordCount = 0;
+    const char *previous = "";
+    for (uint32_t n = 0; n < lineCount; n++) {
+        const char *word = dict_word(dict, lines[n]);
+        if (n && strcmp(word, previous) == 0) {
+            continue;
+        }
+        int prefixLen = 0;
+        while (word[prefixLen] && word[prefixLen] == previous[prefixLen]) {
+            prefixLen++;
+        }
+        add_word(&builder, word, prefixLen);
+        posStart[wordCount++] = n;
+        previous = word;
+    }
+    posStart[wordCount] = lineCount;
+    minimise(&builder, 0);
+
+    DawgHeader header;
+    memset(&header, 0, sizeof(DawgHeader));
+    memcpy(header.magic, DAWG_MAGIC, DAWG_MAGIC_LEN);
+    header.version = DAWG_VERSION;
+    header.wordCount = wordCount;
+    header.lineCount = lineCount;
+    int status = write_dawg(&builder, &header, posStart, lines, dawgName);
+
+    for (int i = 0; i < builder.nodeCount; i++) {
+        free(builder.nodes[i].edges);
+    }
+    free(builder.nodes);
+    free(builder.registry);
+    free(builder.unchecked);
+    free(posStart);
+    free(lines);
+    free_dict(dict);
+    return status;
+}
+
+/* LOADING FUNCTIONS */
+
+/**
+ * Takes in the name of a file and checks whether it starts with the DAWG
+ * magic. Returns 1 if it is a DAWG and 0 otherwise.
+ */
+int is_dawg(const char *fileName) {
+    return has_magic(fileName, DAWG_MAGIC, DAWG_MAGIC_LEN);
+}
+
+/**
+ * Takes in the header of a mapped DAWG, the offset of a section and the
+ * size of that section. Returns 1 if the section lies within the file and
+ * is correctly aligned, and 0 otherwise.
+ */
+static int dawg_section_ok(const DawgHeader *header, uint64_t offset,
+        uint64_t size) {
+    return offset % DAWG_ALIGN == 0 && offset <= header->fileSize &&
+            size <= header->fileSize - offset;
+}
+
+/**
+ * Takes in a DAWG whose sections have been checked, and counts the words
+ * below every node with a depth first walk from the root, checking that
+ * every edge leads to a node and that no path loops back on itself.
+ * Returns an array of the counts (0 for unreachable nodes), or NULL if the
+ * nodes do not form a DAWG or a count exceeds the DAWG's word count.
+ */
+static uint64_t *count_words(const Dawg *dawg) {
+    uint32_t nodeCount = dawg->header->nodeCount;
+    uint64_t *counts = (uint64_t *) calloc(nodeCount, sizeof(uint64_t));
+    uint8_t *state = (uint8_t *) calloc(nodeCount, sizeof(uint8_t));
+    uint32_t *stack = (uint32_t *) malloc(sizeof(uint32_t) * nodeCount);
+    uint32_t *nextEdge = (uint32_t *) calloc(nodeCount, sizeof(uint32_t));
+    int ok = 1;
+    uint32_t depth = 0;
+    stack[depth++] = DAWG_ROOT;
+    state[DAWG_ROOT] = 1;
+
+    // A node is on the stack (state 1) until all of its edges are counted.
+    while (ok && depth) {
+        uint32_t id = stack[depth - 1];
+        const DawgNode *node = &dawg->nodes[id];
+        if (nextEdge[id] == node->edgeCount) {
+            counts[id] += node->final;
+            ok = counts[id] <= dawg->header->wordCount;
+            state[id] = 2;
+            depth--;
+            if (ok && depth) {
+                counts[stack[depth - 1]] += counts[id];
+            }
+            continue;
+        }
+        uint32_t target = dawg->edges[node->firstEdge +
+                nextEdge[id]++].target;
+        if (target >= nodeCount || state[target] == 1) {
+            ok = 0;
+        } else if (state[target] == 2) {
+            counts[id] += counts[target];
+        } else {
+            state[target] = 1;
+            stack[depth++] = target;
+        }
+    }
+    free(state);
+    free(stack);
+    free(nextEdge);
+    if (!ok) {
+        free(counts);
+        return NULL;
+    }
+    return counts;
+}
+
+/**
+ * Takes in a DAWG whose sections have been checked, and checks the nodes,
+ * edges and rank tables. Every node's edges must lie within the edge
+ * section and lead to nodes, every edge's rank offset must be the number
+ * of words before it below its node, so any word found ranks below the
+ * word count, and each rank's positions must lie within the positions.
+ * Returns 1 if the DAWG is valid, and 0 otherwise.
+ */
+static int dawg_ok(const Dawg *dawg) {
+    const DawgHeader *header = dawg->header;
+    for (uint32_t rank = 0; rank < header->wordCount; rank++) {
+        if (dawg->posStart[rank] > dawg->posStart[rank + 1]) {
+            return 0;
+        }
+    }
+    if (dawg->posStart[header->wordCount] > header->lineCount) {
+        return 0;
+    }
+    for (uint32_t id = 0; id < header->nodeCount; id++) {
+        if ((uint64_t)dawg->nodes[id].firstEdge + dawg->nodes[id].edgeCount >
+                header->edgeCount) {
+            return 0;
+        }
+    }
+
+    uint64_t *counts = count_words(dawg);
+    int ok = counts && counts[DAWG_ROOT] == header->wordCount;
+    for (uint32_t id = 0; ok && id < header->nodeCount; id++) {
+        const DawgNode *node = &dawg->nodes[id];
+        uint64_t rank = node->final;
+        for (uint32_t e = 0; ok && e < node->edgeCount; e++) {
+            const DawgEdge *edge = &dawg->edges[node->firstEdge + e];
+            ok = edge->target < header->nodeCount &&
+                    edge->rankOffset == rank;
+            rank += counts[edge->target];
+        }
+    }
+    free(counts);
+    return ok;
+}
+
+/**
+ * The load_dawg function takes in the name of a serialised DAWG and maps
+ * it into memory, using its sections in place once every node, edge and
+ * rank has been checked.
+ * Returns a pointer to the DAWG, or NULL if the file could not be mapped
+ * or is not a valid DAWG of this version.
+ */
+Dawg *load_dawg(const char *fileName) {
+    int fd = open(fileName, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat fileInfo;
+    if (fstat(fd, &fileInfo) < 0 ||
+            (size_t)fileInfo.st_size < sizeof(DawgHeader)) {
+        close(fd);
+        return NULL;
+    }
+    char *base = mmap(NULL, fileInfo.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        return NULL;
+    }
+
+    const DawgHeader *header = (const DawgHeader *)base;
+    if (memcmp(header->magic, DAWG_MAGIC, DAWG_MAGIC_LEN) != 0 ||
+            header->version != DAWG_VERSION ||
+            header->fileSize != (uint64_t)fileInfo.st_size ||
+            header->nodeCount == 0 ||
+            !dawg_section_ok(header, header->nodesOffset,
+                    (uint64_t)header->nodeCount * sizeof(DawgNode)) ||
+            !dawg_section_ok(header, header->edgesOffset,
+                    (uint64_t)header->edgeCount * sizeof(DawgEdge)) ||
+            !dawg_section_ok(header, header->posStartOffset,
+                    ((uint64_t)header->wordCount + 1) * sizeof(uint32_t)) ||
+            !dawg_section_ok(header, header->positionsOffset,
+                    (uint64_t)header->lineCount * sizeof(uint32_t))) {
+        munmap(base, fileInfo.st_size);
+        return NULL;
+    }
+
+    Dawg *dawg = (Dawg *) malloc(sizeof(Dawg));
+    dawg->base = base;
+    dawg->mapSize = fileInfo.st_size;
+    dawg->header = header;
+    dawg->nodes = (const DawgNode *)(base + header->nodesOffset);
+    dawg->edges = (const DawgEdge *)(base + header->edgesOffset);
+    dawg->posStart = (const uint32_t *)(base + header->posStartOffset);
+    dawg->positions = (const uint32_t *)(base + header->positionsOffset);
+    if (!dawg_ok(dawg)) {
+        free_dawg(dawg);
+        return NULL;
+    }
+    return dawg;
+}
+
+/**
+ * Takes in a loaded DAWG and releases its mapping. Returns nothing.
+ */
+void free_dawg(Dawg *dawg) {
+    if (dawg) {
+        munmap(dawg->base, dawg->mapSize);
+        free(dawg);
+    }
+}
+
+/* SEARCH FUNCTIONS */
+
+/**
+ * Takes in the search state, the length of the word spelt so far and its
+ * rank, and adds the word to the arena of matches. Returns nothing.
+ */
+static void add_dawg_match(DawgSearch *search, int depth, uint32_t rank) {
+    int index = arena_add(search->found, search->path, depth);
+    if (index < 0) {
+        return;
+    }
+    if (index == search->rankCap) {
+        search->rankCap = search->rankCap ? search->rankCap * 2 :
+                INITIAL_NODES;
+        search->ranks = (uint32_t *) realloc(search->ranks,
+                sizeof(uint32_t) * search->rankCap);
+    }
+    search->ranks[index] = rank;
+}
+
+/**
+ * The walk function takes in the search state, a node, the length of the
+ * word spelt on the way to it and that word's rank. It records the word if
+ * it is complete and valid, then follows only the edges whose letter is
+ * still available, so the cost depends on the prefixes reachable with the
+ * letters rather than on the size of the dictionary. Returns nothing.
+ */
+static void walk(DawgSearch *search, uint32_t id, int depth, uint32_t rank) {
+    const DawgNode *node = &search->dawg->nodes[id];
+    if (node->final && depth >= MIN_WORD_LEN &&
+            (search->includeLetter < 0 || search->includeUsed)) {
+        add_dawg_match(search, depth, rank);
+    }
+
+    for (uint32_t e = 0; e < node->edgeCount; e++) {
+        const DawgEdge *edge = &search->dawg->edges[node->firstEdge + e];
+        int letter = letter_index((char)edge->label);
+        // A blank tile is only used once the letter itself has run out.
+        int blank = letter >= 0 && search->remaining[letter] == 0;
+        if (letter < 0 || (blank && search->blanks == 0)) {
+            continue;
+        }
+        if (blank) {
+            search->blanks--;
+        } else {
+            search->remaining[letter]--;
+        }
+        search->includeUsed += letter == search->includeLetter;
+        search->path[depth] = (char)edge->label;
+
+        walk(search, edge->target, depth + 1, rank + edge->rankOffset);
+
+        search->includeUsed -= letter == search->includeLetter;
+        if (blank) {
+            search->blanks++;
+        } else {
+            search->remaining[letter]++;
+        }
+    }
+}
+
+/**
+ * The comparison function used to put matches back into dictionary order.
+ * It takes in two dictionary line numbers, and orders them ascending.
+ */
+static int cmp_line(const void *line1, const void *line2) {
+    uint64_t value1 = *(const uint64_t *)line1 >> 32;
+    uint64_t value2 = *(const uint64_t *)line2 >> 32;
+    return value1 < value2 ? -1 : value1 > value2;
+}
+
+/**
+ * The dawg_query function takes in the argument structs, a loaded DAWG and
+ * the output stream. It finds every word that can be made from the letters
+ * by walking the DAWG, expands each distinct word back to the dictionary
+ * lines it came from, and writes the words in the same order and format
+ * run_query uses for a dictionary. The search is timed as filtering in
+ * stats, unless it is NULL.
+ * Returns the number of words written, or -1 if they could not be written.
+ */
+int dawg_query(ArgType **argStructs, Dawg *dawg, FILE *output,
+        QueryStats *stats) {
+    double start = stats_clock();
+    DawgSearch search;
+    memset(&search, 0, sizeof(DawgSearch));
+    search.dawg = dawg;
+    search.path = (char *) malloc(strlen(argStructs[2]->data) + NULL_T_SIZE);
+    search.includeLetter = argStructs[1]->data ?
+            letter_index(argStructs[1]->data[0]) : -1;
+    for (int i = 0; argStructs[2]->data[i]; i++) {
+        if (argStructs[2]->data[i] == BLANK_TILE) {
+            search.blanks++;
+        } else {
+            search.remaining[letter_index(argStructs[2]->data[i])]++;
+        }
+    }
+    search.found = new_arena();
+    walk(&search, DAWG_ROOT, 0, 0);
+
+    // Each entry holds a dictionary line above the match it came from.
+    int lineCount = 0;
+    for (int m = 0; m < search.found->wordCount; m++) {
+        uint32_t rank = search.ranks[m];
+        lineCount += dawg->posStart[rank + 1] - dawg->posStart[rank];
+    }
+    uint64_t *entries = (uint64_t *) malloc(sizeof(uint64_t) *
+            (lineCount ? lineCount : 1));
+    int entry = 0;
+    for (int m = 0; m < search.found->wordCount; m++) {
+        uint32_t rank = search.ranks[m];
+        for (uint32_t p = dawg->posStart[rank]; p < dawg->posStart[rank + 1];
+                p++) {
+            entries[entry++] = ((uint64_t)dawg->positions[p] << 32) | m;
+        }
+    }
+    qsort(entries, lineCount, sizeof(uint64_t), cmp_line);
+
+    uint32_t *words = (uint32_t *) malloc(sizeof(uint32_t) *
+            (lineCount ? lineCount : 1));
+    for (int i = 0; i < lineCount; i++) {
+        words[i] = (uint32_t)entries[i];
+    }
+    lineCount = rank_words(argStructs, search.found, words, lineCount);
+    if (stats) {
+        stats->filter += stats_clock() - start;
+        stats->matched += lineCount;
+    }
+    int printed = output_words(argStructs, search.found, words, lineCount,
+            0, output, stats);
+
+    free(words);
+    free(entries);
+    free(search.path);
+    free(search.ranks);
+    free_dict(search.found);
+    return printed;
+}
+
+/**
+ * Handles "unjumble -dawg dictionary output", which builds a DAWG from a
+ * dictionary and serialises it so later queries can search it directly.
+ * It takes in the command line arguments and the argument structs, and
+ * exits with 0 on success, 1 on a usage error, 2 if the dictionary cannot
+ * be opened, and 5 if the DAWG cannot be written.
+ */
+void dawg_mode(int argc, char **argv, ArgType **argStructs) {
+    if (argc != 4) {
+        fprintf(stderr, DAWG_USAGE);
+        free_structs(argStructs);
+        exit(1);
+    }
+    argStructs[3]->data = strdup(argv[2]);
+
+    int status = build_dawg(argv[2], argv[3]);
+    err_check(status, argStructs);
+    if (status == 5) {
+        fprintf(stderr, "unjumble: DAWG \"%s\" can not be written\n",
+                argv[3]);
+        free_structs(argStructs);
+        exit(5);
+    }
+    free_structs(argStructs);
+    exit(0);
+}
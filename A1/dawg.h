@@ -0,0 +1,115 @@
+#ifndef _DAWG_H
+#define _DAWG_H
+
+#include <stdint.h>
+#include "unjumble.h"
+
+// Macro Definitions
+#define DAWG_MAGIC "\177UNJDAWG"
+#define DAWG_MAGIC_LEN 8
+#define DAWG_VERSION 1
+#define DAWG_ALIGN 8
+#define DAWG_ROOT 0
+#define INITIAL_NODES 1024
+#define INITIAL_REGISTER 1024
+#define DAWG_USAGE "Usage: unjumble -dawg dictionary output\n"
+
+// A node of the DAWG as stored on disk. Its outgoing edges are contiguous
+// and sorted by label.
+typedef struct {
+    uint32_t firstEdge;     // Index of the node's first edge
+    uint16_t edgeCount;     // Number of outgoing edges
+    uint8_t final;          // True if a word ends at this node
+    uint8_t pad;
+} DawgNode;
+
+// An edge of the DAWG as stored on disk. rankOffset is the number of words
+// that sort (by byte value) before any word through this edge, among the
+// words below the edge's source node, so summing it along a path gives the
+// rank of the word the path spells.
+typedef struct {
+    uint32_t target;        // Node the edge leads to
+    uint32_t rankOffset;    // Words ranked before those through this edge
+    uint8_t label;          // Byte of the word this edge consumes
+    uint8_t pad[3];
+} DawgEdge;
+
+// The header at the start of a serialised DAWG. Section offsets are
+// relative to the start of the file and aligned to DAWG_ALIGN bytes.
+typedef struct {
+    char magic[DAWG_MAGIC_LEN];  // DAWG_MAGIC, including its terminator
+    uint32_t version;            // DAWG_VERSION of the writer
+    uint32_t nodeCount;          // Number of nodes, the root being first
+    uint32_t edgeCount;          // Number of edges
+    uint32_t wordCount;          // Number of distinct words
+    uint32_t lineCount;          // Number of dictionary lines they came from
+    uint32_t pad;
+    uint64_t fileSize;           // Total size of the DAWG file
+    uint64_t nodesOffset;        // DawgNode of each node
+    uint64_t edgesOffset;        // DawgEdge of each edge
+    uint64_t posStartOffset;     // uint32_t first position of each rank
+    uint64_t positionsOffset;    // uint32_t dictionary line of each word
+} DawgHeader;
+
+// A serialised DAWG mapped into memory.
+typedef struct {
+    char *base;                 // Start of the mapping
+    size_t mapSize;             // Size of the mapping in bytes
+    const DawgHeader *header;   // The file header
+    const DawgNode *nodes;      // Every node, the root being first
+    const DawgEdge *edges;      // Every edge, grouped by source node
+    const uint32_t *posStart;   // Where each rank's positions start
+    const uint32_t *positions;  // Dictionary line numbers, grouped by rank
+} Dawg;
+
+// An edge of a node while the DAWG is being built.
+typedef struct {
+    unsigned char label;    // Byte of the word this edge consumes
+    int target;             // Node the edge leads to
+} BuildEdge;
+
+// A node of the DAWG while it is being built.
+typedef struct {
+    int final;              // True if a word ends at this node
+    int edgeCount;          // Number of outgoing edges
+    int edgeCap;            // Room in the edges array
+    BuildEdge *edges;       // Outgoing edges, in increasing label order
+} BuildNode;
+
+// The state of the incremental construction of a minimal DAWG from words
+// added in sorted order.
+typedef struct {
+    BuildNode *nodes;       // Every node created so far
+    int nodeCount;
+    int nodeCap;
+    int *registry;          // Hash table of minimised node ids, -1 if empty
+    int registryCap;
+    int registryCount;
+    int *unchecked;         // Path of nodes not yet minimised, root first
+    int uncheckedCount;
+    int uncheckedCap;
+} DawgBuilder;
+
+// The state of a generative search through the DAWG.
+typedef struct {
+    const Dawg *dawg;
+    int remaining[ALPHABET_SIZE];   // Letters still available to the word
+    int includeLetter;              // Index of the -include letter, or -1
+    int includeUsed;                // Times the -include letter was used
+    int blanks;                     // Blank tiles still available
+    char *path;                     // The word spelt so far
+    Dict *found;                    // Arena of every match, in byte order
+    uint32_t *ranks;                // Rank of each match among the words
+    int rankCap;
+} DawgSearch;
+
+// Function Declarations
+int is_dawg(const char *fileName);
+Dawg *load_dawg(const char *fileName);
+void free_dawg(Dawg *dawg);
+int build_dawg(const char *dictName, const char *dawgName);
+int dawg_query(ArgType **argStructs, Dawg *dawg, FILE *output,
+        QueryStats *stats);
+void dawg_mode(int argc, char **argv, ArgType **argStructs);
+
+#endif
@@ -0,0 +1,302 @@
+/**
+ * Author: Ethan Pinto
+ * Student Number: s4642286
+ * Program Name: unjumble
+ * File Name: dict.c
+**/
+
+#include "dict.h"
+#include "cache.h"
+#include "dawg.h"
+#include "index.h"
+#include "pattern.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+ * The read_file function takes in an open file descriptor, the memory to
+ * read the file into and the size the file had when it was opened. The
+ * whole file is read, and it must still be exactly that size, so a file
+ * truncated or extended while it is read is never taken as complete.
+ * Returns 0 on success, and -1 otherwise.
+ */
+int read_file(int fd, char *into, size_t fileSize) {
+    size_t done = 0;
+    while (done < fileSize) {
+        ssize_t got = read(fd, into + done, fileSize - done);
+        if (got <= 0) {
+            return -1;
+        }
+        done += got;
+    }
+    char extra;
+    return read(fd, &extra, 1) == 0 ? 0 : -1;
+}
+
+/**
+ * The map_file function takes in an open file descriptor, the size of the
+ * file, and whether to copy the file rather than map it. It maps the file
+ * privately (so it can be written to without changing the file) and makes
+ * sure there is at least one zeroed byte after the end of the file, so the
+ * last word can always be terminated in place. A copy is read into private
+ * memory instead, so it can never be changed or truncated by a writer.
+ * Returns the mapping, or NULL if the file could not be mapped or read.
+ */
+static char *map_file(int fd, size_t fileSize, int copy, size_t *mapSize) {
+    *mapSize = fileSize + 1;
+
+    // Reserve zeroed memory for the file plus its terminator.
+    char *pool = mmap(NULL, *mapSize, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pool == MAP_FAILED) {
+        return NULL;
+    }
+    if (fileSize == 0) {
+        return pool;
+    }
+    if (copy) {
+        if (read_file(fd, pool, fileSize) < 0) {
+            munmap(pool, *mapSize);
+            return NULL;
+        }
+        return pool;
+    }
+
+    // Place the file over the start of the reserved region.
+    if (mmap(pool, fileSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED,
+            fd, 0) == MAP_FAILED) {
+        munmap(pool, *mapSize);
+        return NULL;
+    }
+    madvise(pool, fileSize, MADV_SEQUENTIAL);
+    return pool;
+}
+
+/**
+ * Takes in a dictionary and the number of words its arrays should have
+ * room for, which must be more than they have now. Each column of letter
+ * counts is moved to its new place, last column first, and the new room in
+ * it is zeroed. Returns 0 on success, and -1 if memory could not be
+ * allocated.
+ */
+static int grow_words(Dict *dict, int capacity) {
+    uint64_t *offsets = (uint64_t *) realloc(dict->offsets,
+            sizeof(uint64_t) * capacity);
+    if (offsets) {
+        dict->offsets = offsets;
+    }
+    int *lengths = (int *) realloc(dict->lengths, sizeof(int) * capacity);
+    if (lengths) {
+        dict->lengths = lengths;
+    }
+    uint32_t *masks = (uint32_t *) realloc(dict->masks,
+            sizeof(uint32_t) * capacity);
+    if (masks) {
+        dict->masks = masks;
+    }
+    // Fresh columns come zeroed from calloc, so only grown ones need it.
+    int fresh = !dict->counts;
+    uint8_t *counts = fresh ? (uint8_t *) calloc(ALPHABET_SIZE, capacity) :
+            (uint8_t *) realloc(dict->counts,
+            (size_t)ALPHABET_SIZE * capacity);
+    if (counts) {
+        dict->counts = counts;
+    }
+    if (!offsets || !lengths || !masks || !counts) {
+        return -1;
+    }
+    for (int letter = ALPHABET_SIZE - 1; letter >= 0 && !fresh; letter--) {
+        uint8_t *column = counts + (size_t)letter * capacity;
+        memmove(column, counts + (size_t)letter * dict->wordCap,
+                dict->wordCap);
+        memset(column + dict->wordCap, 0, capacity - dict->wordCap);
+    }
+    dict->countStride = capacity;
+    dict->wordCap = capacity;
+    return 0;
+}
+
+/**
+ * Takes in a dictionary with room for another word, and the word's text
+ * and length. Records the word's letter mask and scatters its letter
+ * counts into their columns. Returns nothing.
+ */
+static void add_signature(Dict *dict, const char *word, int length) {
+    Signature sig;
+    make_signature(word, length, &sig);
+    dict->masks[dict->wordCount] = sig.mask;
+    for (uint32_t left = sig.mask & LETTER_BITS; left; left &= left - 1) {
+        int letter = __builtin_ctz(left);
+        dict->counts[dict->countStride * letter + dict->wordCount] =
+                sig.counts[letter];
+    }
+}
+
+/**
+ * The tokenize function takes in a dictionary whose pool has just been
+ * mapped, along with the size of the file. It walks the text once,
+ * recording the offset, length and letter counts of every line and
+ * replacing each newline with a null terminator. Returns 0 on success,
+ * and -1 if memory could not be allocated.
+ */
+static int tokenize(Dict *dict, size_t fileSize) {
+    // Count the lines first so the count columns never have to move.
+    int lines = 0;
+    for (char *line = dict->pool; line < dict->pool + fileSize; lines++) {
+        char *newline = memchr(line, '\n', dict->pool + fileSize - line);
+        line = newline ? newline + 1 : dict->pool + fileSize;
+    }
+    if (lines && grow_words(dict, lines) < 0) {
+        return -1;
+    }
+
+    size_t start = 0;
+    while (start < fileSize) {
+        // Find the end of the current line.
+        char *newline = memchr(dict->pool + start, '\n', fileSize - start);
+        size_t end = newline ? (size_t)(newline - dict->pool) : fileSize;
+
+        // Terminate the word in place and record where it lives.
+        dict->pool[end] = '\0';
+        dict->offsets[dict->wordCount] = start;
+        dict->lengths[dict->wordCount] = (int)(end - start);
+        add_signature(dict, dict->pool + start, (int)(end - start));
+        dict->wordCount++;
+        start = end + 1;
+    }
+    return 0;
+}
+
+/**
+ * The open_dict function takes in the name of a dictionary file and
+ * whether to copy it rather than map it, and loads it with a single pass
+ * over its contents. No per-word memory is allocated; each word is a view
+ * into the mapping or copy. Compiled index files are recognised by their
+ * header and used directly instead. A DAWG is not a word list, and is
+ * never read as one.
+ * Returns a pointer to the loaded dictionary, or NULL if the file could not
+ * be opened or read, or is a DAWG.
+ */
+static Dict *open_dict(const char *fileName, int copy) {
+    if (is_index(fileName)) {
+        return load_index(fileName, copy);
+    } else if (has_magic(fileName, DAWG_MAGIC, DAWG_MAGIC_LEN)) {
+        return NULL;
+    }
+    int fd = open(fileName, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat fileInfo;
+    if (fstat(fd, &fileInfo) < 0 || !S_ISREG(fileInfo.st_mode)) {
+        close(fd);
+        return NULL;
+    }
+
+    Dict *dict = (Dict *) calloc(1, sizeof(Dict));
+    size_t fileSize = (size_t)fileInfo.st_size;
+    dict->pool = map_file(fd, fileSize, copy, &dict->mapSize);
+    dict->base = dict->pool;
+    dict->poolSize = fileSize + 1;
+    // The mapping stays valid after the descriptor is closed.
+    close(fd);
+
+    if (!dict->pool || tokenize(dict, fileSize) < 0) {
+        free_dict(dict);
+        return NULL;
+    }
+    return dict;
+}
+
+/**
+ * Takes in the name of a dictionary file, and maps it into memory as
+ * described for open_dict. Returns the dictionary, or NULL if the file
+ * could not be opened or read.
+ */
+Dict *load_dict(const char *fileName) {
+    return open_dict(fileName, 0);
+}
+
+/**
+ * Takes in the name of a dictionary file, and reads it into private memory
+ * as described for open_dict, for a process that must keep answering
+ * queries however the file is changed. Returns the dictionary, or NULL if
+ * the file could not be opened or read in full.
+ */
+Dict *copy_dict(const char *fileName) {
+    return open_dict(fileName, 1);
+}
+
+/**
+ * Creates an empty arena: a dictionary whose words are appended at run
+ * time into one growable pool rather than mapped from a file.
+ * Returns a pointer to the arena.
+ */
+Dict *new_arena(void) {
+    Dict *arena = (Dict *) calloc(1, sizeof(Dict));
+    arena->arena = 1;
+    arena->poolCap = INITIAL_POOL;
+    arena->pool = (char *) malloc(arena->poolCap);
+    return arena;
+}
+
+/**
+ * The arena_add function takes in an arena, a word and its length, and
+ * copies the word onto the end of the arena's pool, recording its offset,
+ * length and letter counts like a dictionary word.
+ * Returns the index of the new word, or -1 if memory could not be
+ * allocated.
+ */
+int arena_add(Dict *arena, const char *word, int length) {
+    if (arena->poolSize + length + 1 > arena->poolCap) {
+        size_t capacity = (arena->poolCap + length + 1) * 2;
+        char *pool = (char *) realloc(arena->pool, capacity);
+        if (!pool) {
+            return -1;
+        }
+        arena->pool = pool;
+        arena->poolCap = capacity;
+    }
+    if (arena->wordCount == arena->wordCap && grow_words(arena,
+            arena->wordCap ? arena->wordCap * 2 : INITIAL_WORDS) < 0) {
+        return -1;
+    }
+    memcpy(arena->pool + arena->poolSize, word, length);
+    arena->pool[arena->poolSize + length] = '\0';
+    arena->offsets[arena->wordCount] = arena->poolSize;
+    arena->lengths[arena->wordCount] = length;
+    add_signature(arena, word, length);
+    arena->poolSize += length + 1;
+    return arena->wordCount++;
+}
+
+/**
+ * Takes in a loaded dictionary or arena and releases the mapping or pool
+ * and the word arrays and cached results that belong to it.
+ * Returns nothing.
+ */
+void free_dict(Dict *dict) {
+    if (!dict) {
+        return;
+    }
+    if (dict->base) {
+        munmap(dict->base, dict->mapSize);
+    }
+    if (dict->arena) {
+        free(dict->pool);
+    }
+    if (!dict->indexed) {
+        free(dict->offsets);
+        free(dict->lengths);
+        free(dict->masks);
+        free(dict->counts);
+    }
+    free_patterns(dict->patterns);
+    free_cache(dict->cache);
+    free(dict);
+}
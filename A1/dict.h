@@ -0,0 +1,101 @@
+#ifndef _DICT_H
+#define _DICT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "signature.h"
+
+// Initial capacity of the word arrays and of an arena's text.
+#define INITIAL_WORDS 1024
+#define INITIAL_POOL 4096
+
+// Positional bitmaps for pattern queries, defined in pattern.h.
+typedef struct PatternIndex PatternIndex;
+
+// Results of recent queries, defined in cache.h.
+typedef struct ResultCache ResultCache;
+
+// A dictionary file mapped into memory. Each line of the file is a word,
+// terminated in place by overwriting its newline with a null terminator,
+// so words are views into the mapping rather than separate allocations.
+// Letter counts are stored by column, so a filter can test many words'
+// counts of one letter with a single vector load.
+// A compiled index is mapped the same way, with every array in the file.
+// Either can be copied into private memory instead of mapped, so changes
+// to the file can never reach it.
+// An arena holds words built at run time the same way, in one growable
+// pool, so every word set shares one offset/length representation.
+typedef struct {
+    char *base;             // Start of the mapping
+    size_t mapSize;         // Size of the mapping in bytes
+    int indexed;            // True if the arrays live in a compiled index
+    int arena;              // True if the pool is a growable allocation
+    char *pool;             // The null terminated word text
+    size_t poolSize;        // Size of the word text in bytes
+    size_t poolCap;         // Room in the pool of an arena
+    int wordCount;          // Number of words (lines) in the dictionary
+    int wordCap;            // Room in the word arrays
+    uint64_t *offsets;      // Offset of each word within the pool
+    int *lengths;           // Length of each word, excluding the terminator
+    uint32_t *masks;        // Letter presence bits and flags of each word
+    uint8_t *counts;        // Letter counts, one column per letter
+    size_t countStride;     // Distance between the columns of counts
+    uint32_t *alphaOrder;   // Word indices in -alpha order, if presorted
+    uint32_t *lenOrder;     // Word indices in -len order, if presorted
+    PatternIndex *patterns; // Positional bitmaps, built when first needed
+    ResultCache *cache;     // Results of recent queries, or NULL
+} Dict;
+
+// Function Declarations
+int read_file(int fd, char *into, size_t fileSize);
+Dict *load_dict(const char *fileName);
+Dict *copy_dict(const char *fileName);
+Dict *new_arena(void);
+int arena_add(Dict *arena, const char *word, int length);
+void free_dict(Dict *dict);
+
+/**
+ * Returns a pointer to the null terminated word at the given index.
+ */
+static inline char *dict_word(const Dict *dict, int index) {
+    return dict->pool + dict->offsets[index];
+}
+
+/**
+ * Returns how many times the given letter occurs in the word at the given
+ * index. The counts of a letter for consecutive words are contiguous.
+ */
+static inline uint8_t letter_count(const Dict *dict, int letter, int index) {
+    return dict->counts[dict->countStride * letter + index];
+}
+
+/**
+ * Takes in a dictionary, the index of a word, the signature of the letters
+ * argument and the number of blank tiles in it. Counts, in one pass over
+ * the word's letters, how many letters the word needs beyond those given.
+ * Returns 1 if the blanks can make up that shortfall, and -1 otherwise.
+ */
+static inline int word_fits(const Dict *dict, int index,
+        const Signature *letters, int blanks) {
+    uint32_t mask = dict->masks[index];
+    // Without blanks, a word using a letter absent from the letters never
+    // fits. Blanks stand in for any letter, but never for anything else.
+    uint32_t blankable = blanks ? LETTER_BITS | OVERFLOW_BIT : 0;
+    if (mask & ~letters->mask & ~blankable) {
+        return -1;
+    }
+    int shortfall = 0;
+    for (uint32_t left = mask & LETTER_BITS; left; left &= left - 1) {
+        int letter = __builtin_ctz(left);
+        int count = letter_count(dict, letter, index);
+        if (count > letters->counts[letter]) {
+            shortfall += count - letters->counts[letter];
+            if (shortfall > blanks) {
+                return -1;
+            }
+        }
+    }
+    return 1;
+}
+
+#endif
@@ -0,0 +1,322 @@
+/**
+ * Author: Ethan Pinto
+ * Student Number: s4642286
+ * Program Name: unjumble
+ * File Name: filter.c
+**/
+
+#include "filter.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define FILTER_AVX2
+#include <immintrin.h>
+#endif
+
+/**
+ * The prepare_query function takes in a pointer to the query to fill in,
+ * the letters argument and the -include letter (or NULL if there is none).
+ * It builds the letter histogram of the letters once, so each word can be
+ * matched against it in constant time, and counts the blank tiles, which
+ * are left out of the histogram. A pattern query may have no letters, in
+ * which case letters is NULL and the histogram is empty. Returns nothing.
+ */
+void prepare_query(Query *query, const char *letters, const char *include) {
+    query->letters = letters;
+    query->lettersLen = letters ? strlen(letters) : 0;
+    make_signature(letters, query->lettersLen, &query->lettersSig);
+    query->blanks = 0;
+    for (int i = 0; i < query->lettersLen; i++) {
+        query->blanks += letters[i] == BLANK_TILE;
+    }
+    // Blanks are the only characters that are not letters.
+    query->lettersSig.mask &= ~NON_ALPHA_BIT;
+    query->includeBit = 0;
+    query->longest = 0;
+    query->ranking = NULL;
+    query->stats = NULL;
+    if (include) {
+        query->includeBit = 1u << letter_index(include[0]);
+    }
+}
+
+/**
+ * Takes in a filter job and the index of a word whose letters fit the
+ * query, and appends the index to the job's matches. Counts that
+ * overflowed on both sides are checked exactly first. For a -longest query
+ * the word is dropped if it is shorter than the longest match so far, and
+ * the shorter matches are dropped if it is longer. Returns nothing.
+ */
+static inline void keep_match(FilterJob *job, int i) {
+    const Dict *dict = job->dict;
+    const Query *query = job->query;
+    if (query->longest && dict->lengths[i] < job->maxLength) {
+        job->rejected[REJECT_LENGTH]++;
+        return;
+    }
+    if ((dict->masks[i] & OVERFLOW_BIT) &&
+            exact_fit(dict_word(dict, i), query->letters) == -1) {
+        job->rejected[REJECT_LETTERS]++;
+        return;
+    }
+    job->matched++;
+    if (query->ranking) {
+        heap_offer(dict, query->ranking, job->matches, &job->count, i);
+        return;
+    }
+    if (dict->lengths[i] > job->maxLength) {
+        job->maxLength = dict->lengths[i];
+        if (query->longest) {
+            job->count = 0;
+        }
+    }
+    job->matches[job->count++] = i;
+}
+
+#ifdef FILTER_AVX2
+
+/**
+ * Takes in the dictionary, a prepared query and the index of the first of
+ * FILTER_BLOCK consecutive words. Tests the lengths, letter masks and the
+ * count of every letter of the query for all of the words at once, eight
+ * or thirty-two lanes to an instruction. With blank tiles, every letter's
+ * shortfall is totalled instead and compared with the number of blanks.
+ * The words with the wrong length, and those without the -include letter,
+ * are also marked in the two given masks.
+ * Returns a bit mask with bit n set if word start + n fits the query.
+ */
+__attribute__((target("avx2")))
+static uint32_t filter_block_avx2(const Dict *dict, const Query *query,
+        int start, uint32_t *lengthBad, uint32_t *includeBad) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i maxLength = _mm256_set1_epi32(query->lettersLen);
+    const __m256i minLength = _mm256_set1_epi32(MIN_WORD_LEN);
+    uint32_t blankable = query->blanks ? LETTER_BITS | OVERFLOW_BIT : 0;
+    const __m256i absent = _mm256_set1_epi32(~query->lettersSig.mask &
+            ~blankable);
+    const __m256i include = _mm256_set1_epi32(query->includeBit);
+    uint32_t fits = 0;
+    *lengthBad = 0;
+    *includeBad = 0;
+
+    // Eight lengths and masks to a register.
+    for (int part = 0; part < FILTER_BLOCK / 8; part++) {
+        __m256i lengths = _mm256_loadu_si256((const __m256i *)
+                (dict->lengths + start + 8 * part));
+        __m256i masks = _mm256_loadu_si256((const __m256i *)
+                (dict->masks + start + 8 * part));
+        __m256i bad = _mm256_or_si256(_mm256_cmpgt_epi32(lengths, maxLength),
+                _mm256_cmpgt_epi32(minLength, lengths));
+        *lengthBad |= (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(bad))
+                << (8 * part);
+        if (query->includeBit) {
+            __m256i missing = _mm256_cmpeq_epi32(
+                    _mm256_and_si256(masks, include), zero);
+            *includeBad |= (uint32_t)_mm256_movemask_ps(
+                    _mm256_castsi256_ps(missing)) << (8 * part);
+            bad = _mm256_or_si256(bad, missing);
+        }
+        bad = _mm256_or_si256(bad, _mm256_xor_si256(_mm256_cmpeq_epi32(
+                _mm256_and_si256(masks, absent), zero),
+                _mm256_set1_epi32(-1)));
+        uint32_t partFits = ~_mm256_movemask_ps(_mm256_castsi256_ps(bad));
+        fits |= (partFits & 0xff) << (8 * part);
+    }
+
+    if (!query->blanks) {
+        // Thirty-two counts of one letter to a register.
+        for (uint32_t left = query->lettersSig.mask & LETTER_BITS;
+                left && fits; left &= left - 1) {
+            int letter = __builtin_ctz(left);
+            __m256i limit = _mm256_set1_epi8(
+                    (char)query->lettersSig.counts[letter]);
+            __m256i counts = _mm256_loadu_si256((const __m256i *)
+                    (dict->counts + dict->countStride * letter + start));
+            __m256i within = _mm256_cmpeq_epi8(
+                    _mm256_max_epu8(counts, limit), limit);
+            fits &= (uint32_t)_mm256_movemask_epi8(within);
+        }
+        return fits;
+    }
+
+    // Total each word's shortfall over every letter. It saturates at 255,
+    // so the kernel is only used with fewer blanks than that.
+    __m256i shortfall = zero;
+    for (int letter = 0; letter < ALPHABET_SIZE && fits; letter++) {
+        __m256i limit = _mm256_set1_epi8(
+                (char)query->lettersSig.counts[letter]);
+        __m256i counts = _mm256_loadu_si256((const __m256i *)
+                (dict->counts + dict->countStride * letter + start));
+        shortfall = _mm256_adds_epu8(shortfall,
+                _mm256_subs_epu8(counts, limit));
+    }
+    __m256i allowed = _mm256_set1_epi8((char)query->blanks);
+    fits &= (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(
+            _mm256_max_epu8(shortfall, allowed), allowed));
+    return fits;
+}
+
+/**
+ * Returns 1 if the processor running the program supports AVX2, and 0
+ * otherwise.
+ */
+static int has_avx2(void) {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+}
+
+#endif
+
+/**
+ * The filter_range function is a thread handling function. It takes in a
+ * void pointer to a FilterJob and compacts the index of every word in the
+ * job's range that can be made with the letters (and contains the -include
+ * letter, if one was given) into the front of the job's part of the match
+ * array, in scan order. For a -longest query only the matches of the
+ * longest length seen so far are kept, so no later sort is needed to find
+ * them. Words in dictionary order are tested FILTER_BLOCK at a time with
+ * the vector kernel when the processor supports it, and one at a time
+ * otherwise. The words looked at, and the check each word that was
+ * rejected failed, are counted in the job. Returns NULL.
+ */
+void *filter_range(void *filterJob) {
+    FilterJob *job = (FilterJob *)filterJob;
+    const Dict *dict = job->dict;
+    const Query *query = job->query;
+    job->count = 0;
+    job->maxLength = 0;
+    job->scanned = 0;
+    memset(job->rejected, 0, sizeof(job->rejected));
+    job->matched = 0;
+    int n = job->start;
+
+#ifdef FILTER_AVX2
+    if (!job->order && query->blanks < MAX_LETTER_COUNT && has_avx2()) {
+        for (; n + FILTER_BLOCK <= job->end; n += FILTER_BLOCK) {
+            uint32_t lengthBad, includeBad;
+            uint32_t fits = filter_block_avx2(dict, query, n, &lengthBad,
+                    &includeBad);
+            includeBad &= ~lengthBad;
+            job->scanned += FILTER_BLOCK;
+            job->rejected[REJECT_LENGTH] += __builtin_popcount(lengthBad);
+            job->rejected[REJECT_INCLUDE] += __builtin_popcount(includeBad);
+            job->rejected[REJECT_LETTERS] += FILTER_BLOCK -
+                    __builtin_popcount(lengthBad | includeBad | fits);
+            for (; fits; fits &= fits - 1) {
+                keep_match(job, n + __builtin_ctz(fits));
+            }
+        }
+    }
+#endif
+
+    // Test the rest of the range one word at a time.
+    for (; n < job->end; n++) {
+        int i = job->order ? (int)job->order[n] : n;
+        job->scanned++;
+        if (query->longest && dict->lengths[i] < job->maxLength) {
+            job->rejected[REJECT_LENGTH]++;
+            // A length ordered scan can never find a longer match again.
+            if (job->order && job->order == dict->lenOrder) {
+                break;
+            }
+            continue;
+        }
+        if (dict->lengths[i] > query->lettersLen ||
+                dict->lengths[i] < MIN_WORD_LEN) {
+            job->rejected[REJECT_LENGTH]++;
+            continue;
+        }
+        // Remove all words that don't contain the single letter (if present)
+        if (query->includeBit &&
+                has_single_letter(query->includeBit, dict->masks[i]) == -1) {
+            job->rejected[REJECT_INCLUDE]++;
+            continue;
+        }
+        if (word_fits(dict, i, &query->lettersSig, query->blanks) == -1) {
+            job->rejected[REJECT_LETTERS]++;
+            continue;
+        }
+        keep_match(job, i);
+    }
+    return NULL;
+}
+
+/**
+ * The filter_words function takes in a dictionary, a prepared query, the
+ * order to scan the words in (NULL for dictionary order), the number of
+ * threads to use and an index array with room for every word. The scan
+ * order is split into one contiguous range per thread, and each thread
+ * compacts the indices of its matches into its own part of the array. The
+ * parts are then joined in order, so the output is identical to filtering
+ * on a single thread; for a -longest query only the ranges holding the
+ * longest matches are joined. For a -top query each range holds only its
+ * best words, and the best of those are selected from the joined ranges.
+ * Returns the number of matching words.
+ */
+int filter_words(const Dict *dict, const Query *query,
+        const uint32_t *order, int threads, uint32_t *matches) {
+    // Don't hand out ranges too small to be worth a thread.
+    int maxThreads = dict->wordCount / MIN_CHUNK_WORDS + 1;
+    if (threads > maxThreads) {
+        threads = maxThreads;
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+
+    FilterJob jobs[threads];
+    pthread_t threadIds[threads];
+    int started[threads];
+    for (int t = 0; t < threads; t++) {
+        jobs[t].dict = dict;
+        jobs[t].query = query;
+        jobs[t].order = order;
+        jobs[t].start = (int)((long)dict->wordCount * t / threads);
+        jobs[t].end = (int)((long)dict->wordCount * (t + 1) / threads);
+        jobs[t].matches = matches + jobs[t].start;
+    }
+
+    // The first range is filtered on the calling thread.
+    for (int t = 1; t < threads; t++) {
+        started[t] = !pthread_create(&threadIds[t], NULL, filter_range,
+                &jobs[t]);
+        if (!started[t]) {
+            // Fall back to filtering this range on the calling thread.
+            filter_range(&jobs[t]);
+        }
+    }
+    filter_range(&jobs[0]);
+
+    // Join the ranges, moving each range's matches down behind the last.
+    int maxLength = jobs[0].maxLength;
+    for (int t = 1; t < threads; t++) {
+        if (started[t]) {
+            pthread_join(threadIds[t], NULL);
+        }
+        if (jobs[t].maxLength > maxLength) {
+            maxLength = jobs[t].maxLength;
+        }
+    }
+    int matchCount = 0;
+    for (int t = 0; t < threads; t++) {
+        if (query->stats) {
+            query->stats->scanned += jobs[t].scanned;
+            for (int kind = 0; kind < REJECT_KINDS; kind++) {
+                query->stats->rejected[kind] += jobs[t].rejected[kind];
+            }
+            query->stats->matched += jobs[t].matched;
+        }
+        if (query->longest && jobs[t].maxLength < maxLength) {
+            continue;
+        }
+        memmove(matches + matchCount, jobs[t].matches,
+                sizeof(uint32_t) * jobs[t].count);
+        matchCount += jobs[t].count;
+    }
+    if (query->ranking) {
+        matchCount = select_top(dict, query->ranking, matches, matchCount);
+    }
+    return matchCount;
+}
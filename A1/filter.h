@@ -0,0 +1,48 @@
+#ifndef _FILTER_H
+#define _FILTER_H
+
+#include <stdint.h>
+#include "dict.h"
+#include "signature.h"
+#include "stats.h"
+#include "top.h"
+
+// Macro Definitions
+#define MIN_WORD_LEN 3
+#define MAX_THREADS 256
+#define MIN_CHUNK_WORDS 16384
+#define FILTER_BLOCK 32
+
+// The letters argument of a query, prepared once for filtering.
+typedef struct {
+    const char *letters;    // The letters argument
+    int lettersLen;         // Length of the letters argument
+    Signature lettersSig;   // Letter histogram of the letters argument
+    uint32_t includeBit;    // Presence bit of the -include letter, or 0
+    int blanks;             // Number of blank tiles in the letters
+    int longest;            // True if only the longest matches are kept
+    const Ranking *ranking; // Ranking of a -top query, or NULL
+    QueryStats *stats;      // Where the word counts are added, or NULL
+} Query;
+
+// A contiguous range of the scan order filtered by one worker thread.
+typedef struct {
+    const Dict *dict;       // Dictionary being filtered
+    const Query *query;     // The prepared query
+    const uint32_t *order;  // Scan order of the words, or NULL
+    int start;              // First scan position in the range
+    int end;                // One past the last scan position in the range
+    uint32_t *matches;      // Where this range's matching indices are put
+    int count;              // Number of matches found (or kept) in the range
+    int maxLength;          // Length of the longest match in the range
+    long scanned;           // Words looked at in the range
+    long rejected[REJECT_KINDS];    // Words rejected by each check
+    long matched;           // Words that passed every check
+} FilterJob;
+
+// Function Declarations
+void prepare_query(Query *query, const char *letters, const char *include);
+int filter_words(const Dict *dict, const Query *query,
+        const uint32_t *order, int threads, uint32_t *matches);
+
+#endif
@@ -0,0 +1,390 @@
+/**
+ * Author: Ethan Pinto
+ * Student Number: s4642286
+ * Program Name: unjumble
+ * File Name: graph.c
+**/
+
+#include "graph.h"
+#include "filter.h"
+#include "group.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+/**
+ * Takes in a growable block of text, some bytes and their length, and
+ * appends the bytes to the text. Returns nothing.
+ */
+static void append_text(GraphText *text, const char *bytes, size_t length) {
+    if (text->used + length > text->capacity) {
+        text->capacity = (text->used + length) * 2;
+        text->data = (char *) realloc(text->data, text->capacity);
+    }
+    memcpy(text->data + text->used, bytes, length);
+    text->used += length;
+}
+
+/**
+ * Takes in a graph, the parent of a trie node, and the rarity rank and
+ * count of the letter on its edge. Returns the index of the parent's child
+ * on that edge, which is added to the parent's sorted list of children if
+ * it is not there yet.
+ */
+static int child_node(Graph *graph, int parent, int rank, int count) {
+    if (graph->nodeCount == graph->nodeCap) {
+        graph->nodeCap *= 2;
+        graph->trie = (TrieNode *) realloc(graph->trie,
+                sizeof(TrieNode) * graph->nodeCap);
+    }
+    int *link = &graph->trie[parent].child;
+    while (*link != NO_NODE && (graph->trie[*link].rank < rank ||
+            (graph->trie[*link].rank == rank &&
+            graph->trie[*link].count < count))) {
+        link = &graph->trie[*link].sibling;
+    }
+    if (*link != NO_NODE && graph->trie[*link].rank == rank &&
+            graph->trie[*link].count == count) {
+        return *link;
+    }
+    int node = graph->nodeCount++;
+    graph->trie[node].child = NO_NODE;
+    graph->trie[node].sibling = *link;
+    graph->trie[node].classId = -1;
+    graph->trie[node].rank = rank;
+    graph->trie[node].count = count;
+    *link = node;
+    return node;
+}
+
+/**
+ * Takes in a graph whose trie has been built, and lays its nodes out again
+ * in breadth first order, so the children of every node are next to each
+ * other. The linked nodes are freed. Returns nothing.
+ */
+static void pack_trie(Graph *graph) {
+    graph->nodes = (GraphNode *) malloc(sizeof(GraphNode) *
+            graph->nodeCount);
+    int *queue = (int *) malloc(sizeof(int) * graph->nodeCount);
+    int queued = 1;
+    queue[0] = GRAPH_ROOT;
+    graph->nodes[0].letter = 0;
+    graph->nodes[0].count = 0;
+    for (int n = 0; n < queued; n++) {
+        TrieNode *old = &graph->trie[queue[n]];
+        graph->nodes[n].classId = old->classId;
+        graph->nodes[n].child = queued;
+        for (int child = old->child; child != NO_NODE;
+                child = graph->trie[child].sibling) {
+            graph->nodes[queued].letter =
+                    graph->order[graph->trie[child].rank];
+            graph->nodes[queued].count = graph->trie[child].count;
+            queue[queued++] = child;
+        }
+        graph->nodes[n].childCount = queued - graph->nodes[n].child;
+    }
+    free(queue);
+    free(graph->trie);
+    graph->trie = NULL;
+}
+
+/**
+ * The make_graph function takes in a loaded dictionary and the graph to
+ * fill in. Every alphabetic word of at least MIN_WORD_LEN letters is
+ * grouped into its anagram class, and the letters of each class are added
+ * to a trie, from the letter the fewest classes have to the letter the
+ * most have, so a search without a rare letter leaves the classes that
+ * have it near the root. Words with letter counts too large to be stored
+ * exactly are left out. Returns nothing.
+ */
+static void make_graph(Dict *dict, Graph *graph) {
+    graph->dict = dict;
+    graph->words = (uint32_t *) malloc(sizeof(uint32_t) *
+            (dict->wordCount ? dict->wordCount : 1));
+    int wordCount = 0;
+    for (int i = 0; i < dict->wordCount; i++) {
+        if (dict->lengths[i] >= MIN_WORD_LEN &&
+                !(dict->masks[i] & (NON_ALPHA_BIT | OVERFLOW_BIT))) {
+            graph->words[wordCount++] = i;
+        }
+    }
+    graph->classStarts = (int *) malloc(sizeof(int) * (wordCount + 1));
+    graph->classCount = group_words(dict, graph->words, wordCount,
+            graph->classStarts);
+
+    // Join the words of each class once, as every line that lists the
+    // class copies them.
+    memset(&graph->names, 0, sizeof(GraphText));
+    graph->nameStarts = (size_t *) malloc(sizeof(size_t) *
+            (graph->classCount + 1));
+    for (int c = 0; c < graph->classCount; c++) {
+        graph->nameStarts[c] = graph->names.used;
+        for (int i = graph->classStarts[c]; i < graph->classStarts[c + 1];
+                i++) {
+            uint32_t word = graph->words[i];
+            if (i > graph->classStarts[c]) {
+                append_text(&graph->names, " ", 1);
+            }
+            append_text(&graph->names, dict_word(dict, word),
+                    dict->lengths[word]);
+        }
+    }
+    graph->nameStarts[graph->classCount] = graph->names.used;
+
+    // Count the classes with each letter, and rank the letters by it.
+    int classesWith[ALPHABET_SIZE] = {0};
+    for (int c = 0; c < graph->classCount; c++) {
+        uint32_t mask = dict->masks[graph->words[graph->classStarts[c]]];
+        for (uint32_t left = mask & LETTER_BITS; left; left &= left - 1) {
+            classesWith[__builtin_ctz(left)]++;
+        }
+    }
+    for (int rank = 0; rank < ALPHABET_SIZE; rank++) {
+        int letter = rank;
+        while (letter > 0 && classesWith[graph->order[letter - 1]] >
+                classesWith[rank]) {
+            graph->order[letter] = graph->order[letter - 1];
+            letter--;
+        }
+        graph->order[letter] = rank;
+    }
+
+    graph->counts = (uint8_t *) malloc(ALPHABET_SIZE *
+            (graph->classCount ? graph->classCount : 1));
+    graph->nodeCap = INITIAL_GRAPH_NODES;
+    graph->trie = (TrieNode *) malloc(sizeof(TrieNode) * graph->nodeCap);
+    graph->nodeCount = 1;
+    graph->trie[GRAPH_ROOT].child = NO_NODE;
+    graph->trie[GRAPH_ROOT].sibling = NO_NODE;
+    graph->trie[GRAPH_ROOT].classId = -1;
+    for (int c = 0; c < graph->classCount; c++) {
+        uint32_t first = graph->words[graph->classStarts[c]];
+        uint8_t *counts = graph->counts + ALPHABET_SIZE * c;
+        int node = GRAPH_ROOT;
+        for (int rank = 0; rank < ALPHABET_SIZE; rank++) {
+            int letter = graph->order[rank];
+            counts[letter] = letter_count(dict, letter, first);
+            if (counts[letter]) {
+                node = child_node(graph, node, rank, counts[letter]);
+            }
+        }
+        graph->trie[node].classId = c;
+    }
+    pack_trie(graph);
+}
+
+/**
+ * Takes in a graph, a trie node, the letter counts of a class, and a
+ * growable array of class numbers with its length and capacity. Every
+ * class below the node with no more of any letter than the counts is
+ * appended to the array. A class's letters are always added to the trie
+ * in the same order, so each class is reached at most once.
+ * Returns nothing.
+ */
+static void find_contained(const Graph *graph, int node,
+        const uint8_t *counts, int **found, int *foundCount, int *foundCap) {
+    const GraphNode *parent = &graph->nodes[node];
+    for (int child = parent->child;
+            child < parent->child + parent->childCount; child++) {
+        const GraphNode *next = &graph->nodes[child];
+        if (next->count > counts[next->letter]) {
+            continue;
+        }
+        if (next->classId >= 0) {
+            if (*foundCount == *foundCap) {
+                *foundCap *= 2;
+                *found = (int *) realloc(*found, sizeof(int) * *foundCap);
+            }
+            (*found)[(*foundCount)++] = next->classId;
+        }
+        if (next->childCount) {
+            find_contained(graph, child, counts, found, foundCount,
+                    foundCap);
+        }
+    }
+}
+
+/**
+ * Takes in two class numbers and returns a negative number, zero, or a
+ * positive number as the first is less than, equal to or greater than the
+ * second.
+ */
+static int cmp_class(const void *class1, const void *class2) {
+    int value1 = *(const int *)class1;
+    int value2 = *(const int *)class2;
+    return (value1 > value2) - (value1 < value2);
+}
+
+/**
+ * Takes in a graph, a class number, the text to write to, and a growable
+ * array for the contained classes along with its capacity. Appends the
+ * words of the class separated by spaces, then a tab, then the words of
+ * every other class that can be made from its letters (in class order)
+ * separated by spaces, then a newline. Returns nothing.
+ */
+static void class_line(const Graph *graph, int c, GraphText *text,
+        int **found, int *foundCap) {
+    const size_t *starts = graph->nameStarts;
+    append_text(text, graph->names.data + starts[c],
+            starts[c + 1] - starts[c]);
+    append_text(text, "\t", 1);
+
+    int foundCount = 0;
+    find_contained(graph, GRAPH_ROOT, graph->counts + ALPHABET_SIZE * c,
+            found, &foundCount, foundCap);
+    qsort(*found, foundCount, sizeof(int), cmp_class);
+
+    int separate = 0;
+    for (int n = 0; n < foundCount; n++) {
+        int other = (*found)[n];
+        if (other == c) {
+            continue;
+        }
+        if (separate) {
+            append_text(text, " ", 1);
+        }
+        append_text(text, graph->names.data + starts[other],
+                starts[other + 1] - starts[other]);
+        separate = 1;
+    }
+    append_text(text, "\n", 1);
+}
+
+/**
+ * The graph_worker function is a thread handling function. It takes in a
+ * void pointer to a GraphBatch, and keeps claiming the next chunk of
+ * classes in the batch and writing their lines into the chunk's text,
+ * until every chunk has been claimed. Returns NULL.
+ */
+void *graph_worker(void *graphBatch) {
+    GraphBatch *batch = (GraphBatch *)graphBatch;
+    const Graph *graph = batch->graph;
+    int foundCap = GRAPH_CHUNK;
+    int *found = (int *) malloc(sizeof(int) * foundCap);
+
+    while (1) {
+        int chunk = __atomic_fetch_add(&batch->nextChunk, 1,
+                __ATOMIC_RELAXED);
+        if (chunk >= batch->chunkCount) {
+            break;
+        }
+        int start = batch->start + chunk * GRAPH_CHUNK;
+        int end = start + GRAPH_CHUNK;
+        if (end > graph->classCount) {
+            end = graph->classCount;
+        }
+        for (int c = start; c < end; c++) {
+            class_line(graph, c, &batch->texts[chunk], &found, &foundCap);
+        }
+    }
+    free(found);
+    return NULL;
+}
+
+/**
+ * The write_graph function takes in a graph, the number of threads to use
+ * and the output stream. The classes are written in batches of a few
+ * chunks per thread. The threads claim chunks of the batch in turn, and
+ * the chunks are written out in order once the batch is done, so the file
+ * is the same whatever the number of threads.
+ * Returns 0 on success, and -1 if the output could not be written.
+ */
+static int write_graph(const Graph *graph, int threads, FILE *output) {
+    int batchChunks = threads * 4;
+    GraphText *texts = (GraphText *) calloc(batchChunks, sizeof(GraphText));
+    pthread_t threadIds[threads];
+    int started[threads];
+
+    for (int start = 0; start < graph->classCount;
+            start += batchChunks * GRAPH_CHUNK) {
+        GraphBatch batch;
+        batch.graph = graph;
+        batch.start = start;
+        batch.chunkCount = (graph->classCount - start + GRAPH_CHUNK - 1) /
+                GRAPH_CHUNK;
+        if (batch.chunkCount > batchChunks) {
+            batch.chunkCount = batchChunks;
+        }
+        batch.nextChunk = 0;
+        batch.texts = texts;
+
+        // The calling thread works on the batch as well.
+        for (int t = 1; t < threads; t++) {
+            started[t] = !pthread_create(&threadIds[t], NULL, graph_worker,
+                    &batch);
+        }
+        graph_worker(&batch);
+        for (int t = 1; t < threads; t++) {
+            if (started[t]) {
+                pthread_join(threadIds[t], NULL);
+            }
+        }
+        for (int chunk = 0; chunk < batch.chunkCount; chunk++) {
+            fwrite(texts[chunk].data, 1, texts[chunk].used, output);
+            texts[chunk].used = 0;
+        }
+    }
+    for (int chunk = 0; chunk < batchChunks; chunk++) {
+        free(texts[chunk].data);
+    }
+    free(texts);
+    return ferror(output) ? -1 : 0;
+}
+
+/**
+ * Handles "unjumble -graph dictionary output [threads]", which writes the
+ * containment graph of a dictionary: one line for each anagram class,
+ * holding its words, a tab, and every other word that can be made from
+ * its letters. The classes are found with a hash table and the contained
+ * classes with a trie of their sorted letters, so no pair of words is
+ * ever compared. The work is shared between the given number of threads,
+ * or one per processor. It takes in the command line arguments and the
+ * argument structs, and exits with 0 on success, 1 on a usage error, 2 if
+ * the dictionary cannot be opened, and 5 if the output cannot be written.
+ */
+void graph_mode(int argc, char **argv, ArgType **argStructs) {
+    if (argc < MIN_GRAPH_ARGS || argc > MAX_GRAPH_ARGS ||
+            (argc == MAX_GRAPH_ARGS && thread_check(argv[4]) == -1)) {
+        fprintf(stderr, GRAPH_USAGE);
+        free_structs(argStructs);
+        exit(1);
+    }
+    int threads;
+    if (argc == MAX_GRAPH_ARGS) {
+        threads = atoi(argv[4]);
+    } else {
+        long processors = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = processors < 1 ? 1 : processors > MAX_THREADS ?
+                MAX_THREADS : (int)processors;
+    }
+    argStructs[3]->data = strdup(argv[2]);
+    Dict *dict = load_dict(argv[2]);
+    if (!dict) {
+        err_check(2, argStructs);
+    }
+
+    Graph graph;
+    make_graph(dict, &graph);
+    FILE *output = fopen(argv[3], "w");
+    int status = output ? write_graph(&graph, threads, output) : -1;
+    if (output && fclose(output) != 0) {
+        status = -1;
+    }
+    free(graph.words);
+    free(graph.classStarts);
+    free(graph.counts);
+    free(graph.names.data);
+    free(graph.nameStarts);
+    free(graph.nodes);
+    free_dict(dict);
+    if (status == -1) {
+        fprintf(stderr, "unjumble: graph \"%s\" can not be written\n",
+                argv[3]);
+        free_structs(argStructs);
+        exit(5);
+    }
+    free_structs(argStructs);
+    exit(0);
+}
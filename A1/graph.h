@@ -0,0 +1,75 @@
+#ifndef _GRAPH_H
+#define _GRAPH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "unjumble.h"
+
+// Macro Definitions
+#define MIN_GRAPH_ARGS 4
+#define MAX_GRAPH_ARGS 5
+#define GRAPH_ROOT 0
+#define NO_NODE -1
+#define INITIAL_GRAPH_NODES 1024
+#define GRAPH_CHUNK 64
+#define GRAPH_USAGE "Usage: unjumble -graph dictionary output [threads]\n"
+
+// A node of the trie holding the letters of every anagram class. Each
+// edge is one letter and how many times it occurs, and the letters of a
+// path go from the rarest to the most common. While the trie is built the
+// children of a node are kept in a list sorted by letter and count.
+typedef struct {
+    int child;              // First child, or NO_NODE
+    int sibling;            // Next child of the same parent, or NO_NODE
+    int classId;            // Class whose letters end here, or -1
+    uint8_t rank;           // Rarity rank of the letter on the edge
+    uint8_t count;          // Occurrences of the letter on the edge
+} TrieNode;
+
+// A node of the trie once it has been built, with the children of each
+// node stored next to each other.
+typedef struct {
+    int child;              // Index of the first child
+    int childCount;         // Number of children
+    int classId;            // Class whose letters end here, or -1
+    uint8_t letter;         // Letter on the edge into this node
+    uint8_t count;          // Occurrences of the letter on the edge
+} GraphNode;
+
+// A growable block of text.
+typedef struct {
+    char *data;
+    size_t used;
+    size_t capacity;
+} GraphText;
+
+// The anagram classes of a dictionary and the trie used to find, for each
+// class, every class that can be made from its letters.
+typedef struct {
+    Dict *dict;             // Dictionary the classes come from
+    uint32_t *words;        // Words of the classes, class by class
+    int *classStarts;       // Start of each class in words, then the end
+    int classCount;         // Number of classes
+    uint8_t *counts;        // ALPHABET_SIZE letter counts of each class
+    GraphText names;        // Words of each class, separated by spaces
+    size_t *nameStarts;     // Start of each class in names, then the end
+    int order[ALPHABET_SIZE];   // Letters from the rarest to most common
+    TrieNode *trie;         // Nodes of the trie as it is built
+    int nodeCount;          // Number of nodes
+    int nodeCap;            // Room in the trie array
+    GraphNode *nodes;       // Nodes of the built trie
+} Graph;
+
+// The work shared by the threads writing one batch of classes.
+typedef struct {
+    const Graph *graph;     // The classes and trie
+    int start;              // First class of the batch
+    int chunkCount;         // Number of GRAPH_CHUNK class chunks
+    int nextChunk;          // Next chunk to be claimed by a thread
+    GraphText *texts;       // The lines of each chunk
+} GraphBatch;
+
+// Function Declarations
+void graph_mode(int argc, char **argv, ArgType **argStructs);
+
+#endif
@@ -0,0 +1,163 @@
+/**
+ * Author: Ethan Pinto
+ * Student Number: s4642286
+ * Program Name: unjumble
+ * File Name: group.c
+**/
+
+#include "group.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * The all_words function takes in a dictionary, a prepared query with no
+ * letters, the order to scan the words in (NULL for dictionary order) and
+ * an index array with room for every word. It keeps every alphabetic word
+ * of at least MIN_WORD_LEN letters that contains the -include letter, if
+ * one was given, so a whole dictionary can be grouped.
+ * Returns the number of words kept.
+ */
+int all_words(const Dict *dict, const Query *query, const uint32_t *order,
+        uint32_t *matches) {
+    int matchCount = 0;
+    long rejected[REJECT_KINDS] = {0};
+    for (int n = 0; n < dict->wordCount; n++) {
+        uint32_t i = order ? order[n] : (uint32_t)n;
+        if (dict->lengths[i] < MIN_WORD_LEN) {
+            rejected[REJECT_LENGTH]++;
+        } else if (query->includeBit &&
+                !(dict->masks[i] & query->includeBit)) {
+            rejected[REJECT_INCLUDE]++;
+        } else if (dict->masks[i] & NON_ALPHA_BIT) {
+            rejected[REJECT_LETTERS]++;
+        } else {
+            matches[matchCount++] = i;
+        }
+    }
+    if (query->stats) {
+        query->stats->scanned += dict->wordCount;
+        for (int kind = 0; kind < REJECT_KINDS; kind++) {
+            query->stats->rejected[kind] += rejected[kind];
+        }
+        query->stats->matched += matchCount;
+    }
+    return matchCount;
+}
+
+/**
+ * Takes in a dictionary, an array of word indices and its length, and an
+ * array to fill in. Hashes the length, letter mask and letter counts of
+ * every word, reading the counts one letter column at a time. Letters that
+ * none of the words have are left out. Returns nothing.
+ */
+static void hash_words(const Dict *dict, const uint32_t *words,
+        int wordCount, uint64_t *hashes) {
+    uint32_t letters = 0;
+    for (int j = 0; j < wordCount; j++) {
+        uint32_t word = words[j];
+        letters |= dict->masks[word];
+        hashes[j] = (HASH_SEED ^ dict->masks[word]) * HASH_PRIME;
+        hashes[j] = (hashes[j] ^ (uint64_t)dict->lengths[word]) * HASH_PRIME;
+    }
+    for (letters &= LETTER_BITS; letters; letters &= letters - 1) {
+        const uint8_t *column = dict->counts +
+                dict->countStride * __builtin_ctz(letters);
+        for (int j = 0; j < wordCount; j++) {
+            hashes[j] = (hashes[j] ^ column[words[j]]) * HASH_PRIME;
+        }
+    }
+}
+
+/**
+ * Takes in a dictionary and the indices of two words. Returns 1 if the
+ * words are anagrams of each other, ignoring case, and 0 otherwise.
+ */
+static int same_letters(const Dict *dict, uint32_t word1, uint32_t word2) {
+    uint32_t mask = dict->masks[word1];
+    if (mask != dict->masks[word2] ||
+            dict->lengths[word1] != dict->lengths[word2]) {
+        return 0;
+    }
+    if (mask & OVERFLOW_BIT) {
+        // The counts saturate, but words of one length that fit each
+        // other have the same letters.
+        return exact_fit(dict_word(dict, word1), dict_word(dict, word2)) == 1;
+    }
+    for (uint32_t left = mask & LETTER_BITS; left; left &= left - 1) {
+        int letter = __builtin_ctz(left);
+        if (letter_count(dict, letter, word1) !=
+                letter_count(dict, letter, word2)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * The group_words function takes in a dictionary, an array of word
+ * indices and its length, and an array with room for wordCount + 1
+ * starting positions. Words with the same letters, ignoring case, are
+ * found through an open addressing hash table keyed by their letter
+ * counts, so no word's letters are ever sorted. The words are then
+ * rearranged in place so each anagram class is contiguous. Classes are
+ * ordered by their first word, and the words of a class keep their order.
+ * The start of each class is written to groupStarts, followed by
+ * wordCount. Returns the number of classes.
+ */
+int group_words(const Dict *dict, uint32_t *words, int wordCount,
+        int *groupStarts) {
+    uint64_t *hashes = (uint64_t *) malloc(sizeof(uint64_t) *
+            (wordCount ? wordCount : 1));
+    int *classOf = (int *) malloc(sizeof(int) * (wordCount ? wordCount : 1));
+    int *firsts = (int *) malloc(sizeof(int) * (wordCount ? wordCount : 1));
+    hash_words(dict, words, wordCount, hashes);
+
+    // Keep the table no more than two thirds full.
+    size_t slotCount = 1;
+    while (slotCount < (size_t)wordCount + wordCount / 2 + 1) {
+        slotCount *= 2;
+    }
+    int *slots = (int *) calloc(slotCount, sizeof(int));
+    int groupCount = 0;
+    for (int j = 0; j < wordCount; j++) {
+        size_t slot = hashes[j] & (slotCount - 1);
+        // Each slot holds one more than the class number, or EMPTY_SLOT.
+        while (slots[slot] != EMPTY_SLOT) {
+            int first = firsts[slots[slot] - 1];
+            if (hashes[first] == hashes[j] &&
+                    same_letters(dict, words[first], words[j])) {
+                break;
+            }
+            slot = (slot + 1) & (slotCount - 1);
+        }
+        if (slots[slot] == EMPTY_SLOT) {
+            firsts[groupCount] = j;
+            slots[slot] = ++groupCount;
+        }
+        classOf[j] = slots[slot] - 1;
+    }
+    free(slots);
+    free(hashes);
+
+    // Count the words of each class, then place them class by class.
+    memset(groupStarts, 0, sizeof(int) * (groupCount + 1));
+    for (int j = 0; j < wordCount; j++) {
+        groupStarts[classOf[j] + 1]++;
+    }
+    for (int g = 0; g < groupCount; g++) {
+        groupStarts[g + 1] += groupStarts[g];
+    }
+    // The first word of each class is no longer needed, so its array is
+    // reused to hold the rearranged words.
+    uint32_t *grouped = (uint32_t *) firsts;
+    int *next = (int *) malloc(sizeof(int) * (groupCount ? groupCount : 1));
+    memcpy(next, groupStarts, sizeof(int) * groupCount);
+    for (int j = 0; j < wordCount; j++) {
+        grouped[next[classOf[j]]++] = words[j];
+    }
+    memcpy(words, grouped, sizeof(uint32_t) * wordCount);
+    free(next);
+    free(firsts);
+    free(classOf);
+    return groupCount;
+}
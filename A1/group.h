@@ -0,0 +1,19 @@
+#ifndef _GROUP_H
+#define _GROUP_H
+
+#include <stdint.h>
+#include "dict.h"
+#include "filter.h"
+
+// Macro Definitions
+#define HASH_SEED 0xcbf29ce484222325ull
+#define HASH_PRIME 0x100000001b3ull
+#define EMPTY_SLOT 0
+
+// Function Declarations
+int all_words(const Dict *dict, const Query *query, const uint32_t *order,
+        uint32_t *matches);
+int group_words(const Dict *dict, uint32_t *words, int wordCount,
+        int *groupStarts);
+
+#endif
@@ -0,0 +1,322 @@
+/**
+ * Author: Ethan Pinto
+ * Student Number: s4642286
+ * Program Name: unjumble
+ * File Name: index.c
+**/
+
+#define _GNU_SOURCE
+#include "index.h"
+#include "sort.h"
+#include <stdio.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+ * Takes in the name of a file, the magic of a binary format and its
+ * length, and checks whether the file starts with that magic.
+ * Returns 1 if it does and 0 otherwise.
+ */
+int has_magic(const char *fileName, const char *magic, int length) {
+    char start[length];
+    int fd = open(fileName, O_RDONLY);
+    if (fd < 0) {
+        return 0;
+    }
+    ssize_t numBytes = read(fd, start, length);
+    close(fd);
+    return numBytes == length && memcmp(start, magic, length) == 0;
+}
+
+/**
+ * Takes in the name of a file and checks whether it starts with the
+ * compiled index magic. Returns 1 if it is an index and 0 otherwise.
+ */
+int is_index(const char *fileName) {
+    return has_magic(fileName, INDEX_MAGIC, INDEX_MAGIC_LEN);
+}
+
+/**
+ * Takes in the header of a mapped index, the offset of a section and the
+ * size of that section. Returns 1 if the section lies within the file and
+ * is correctly aligned, and 0 otherwise.
+ */
+static int section_ok(const IndexHeader *header, uint64_t offset,
+        uint64_t size) {
+    return offset % INDEX_ALIGN == 0 && offset <= header->fileSize &&
+            size <= header->fileSize - offset;
+}
+
+/**
+ * Takes in a mapped index whose sections have been checked, and checks
+ * every word entry: each word must lie within the pool and end at a null
+ * terminator, and both orderings may only name words in the index.
+ * Returns 1 if every entry is valid, and 0 otherwise.
+ */
+static int words_ok(const char *base, const IndexHeader *header) {
+    const char *pool = base + header->poolOffset;
+    const uint64_t *offsets = (const uint64_t *)(base +
+            header->offsetsOffset);
+    const int32_t *lengths = (const int32_t *)(base + header->lengthsOffset);
+    const uint32_t *alphaOrder = (const uint32_t *)(base +
+            header->alphaOffset);
+    const uint32_t *lenOrder = (const uint32_t *)(base + header->lenOffset);
+    uint32_t count = header->wordCount;
+
+    for (uint32_t i = 0; i < count; i++) {
+        if (lengths[i] < 0 || offsets[i] >= header->poolSize ||
+                (uint64_t)lengths[i] >= header->poolSize - offsets[i] ||
+                pool[offsets[i] + lengths[i]] != '\0' ||
+                alphaOrder[i] >= count || lenOrder[i] >= count) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * The load_index function takes in the name of a compiled index file and
+ * whether to copy it rather than map it, and maps it into memory or reads
+ * it into private memory. The sections of the index are used in place, so
+ * loading only checks each word entry once and builds nothing.
+ * Returns a pointer to the dictionary, or NULL if the file could not be
+ * mapped or read, or is not a valid index of this version.
+ */
+Dict *load_index(const char *fileName, int copy) {
+    int fd = open(fileName, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat fileInfo;
+    if (fstat(fd, &fileInfo) < 0 ||
+            (size_t)fileInfo.st_size < sizeof(IndexHeader)) {
+        close(fd);
+        return NULL;
+    }
+    char *base = copy ? mmap(NULL, fileInfo.st_size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0) :
+            mmap(NULL, fileInfo.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (base != MAP_FAILED && copy &&
+            read_file(fd, base, fileInfo.st_size) < 0) {
+        munmap(base, fileInfo.st_size);
+        base = MAP_FAILED;
+    }
+    close(fd);
+    if (base == MAP_FAILED) {
+        return NULL;
+    }
+
+    // Check the header describes this file before trusting any section.
+    const IndexHeader *header = (const IndexHeader *)base;
+    uint64_t count = header->wordCount;
+    if (memcmp(header->magic, INDEX_MAGIC, INDEX_MAGIC_LEN) != 0 ||
+            header->version != INDEX_VERSION ||
+            header->fileSize != (uint64_t)fileInfo.st_size ||
+            header->poolSize == 0 ||
+            !section_ok(header, header->poolOffset, header->poolSize) ||
+            base[header->poolOffset + header->poolSize - 1] != '\0' ||
+            !section_ok(header, header->offsetsOffset,
+                    count * sizeof(uint64_t)) ||
+            !section_ok(header, header->lengthsOffset,
+                    count * sizeof(int32_t)) ||
+            !section_ok(header, header->masksOffset,
+                    count * sizeof(uint32_t)) ||
+            !section_ok(header, header->countsOffset,
+                    count * ALPHABET_SIZE) ||
+            !section_ok(header, header->alphaOffset,
+                    count * sizeof(uint32_t)) ||
+            !section_ok(header, header->lenOffset,
+                    count * sizeof(uint32_t)) ||
+            count > INT_MAX || !words_ok(base, header)) {
+        munmap(base, fileInfo.st_size);
+        return NULL;
+    }
+
+    Dict *dict = (Dict *) calloc(1, sizeof(Dict));
+    dict->indexed = 1;
+    dict->base = base;
+    dict->mapSize = fileInfo.st_size;
+    dict->pool = base + header->poolOffset;
+    dict->poolSize = header->poolSize;
+    dict->wordCount = (int)count;
+    dict->offsets = (uint64_t *)(base + header->offsetsOffset);
+    dict->lengths = (int *)(base + header->lengthsOffset);
+    dict->masks = (uint32_t *)(base + header->masksOffset);
+    dict->counts = (uint8_t *)(base + header->countsOffset);
+    dict->countStride = count;
+    dict->alphaOrder = (uint32_t *)(base + header->alphaOffset);
+    dict->lenOrder = (uint32_t *)(base + header->lenOffset);
+    return dict;
+}
+
+/**
+ * Takes in a dictionary and a sorting function, and returns a newly
+ * allocated array of every word index sorted by that function.
+ */
+static uint32_t *make_order(Dict *dict,
+        void (*sort)(const Dict *, uint32_t *, int)) {
+    uint32_t *order = (uint32_t *) malloc(sizeof(uint32_t) *
+            (dict->wordCount ? dict->wordCount : 1));
+    for (int i = 0; i < dict->wordCount; i++) {
+        order[i] = i;
+    }
+    sort(dict, order, dict->wordCount);
+    return order;
+}
+
+/**
+ * Takes in a dictionary and returns a newly allocated copy of its letter
+ * counts with the columns packed together, one word count apart.
+ */
+static uint8_t *pack_counts(Dict *dict) {
+    size_t count = dict->wordCount;
+    uint8_t *counts = (uint8_t *) malloc(ALPHABET_SIZE * count + 1);
+    for (int letter = 0; letter < ALPHABET_SIZE; letter++) {
+        memcpy(counts + letter * count,
+                dict->counts + letter * dict->countStride, count);
+    }
+    return counts;
+}
+
+/**
+ * Takes in an output file, a section of data and its size, and the
+ * current write position. Writes the section padded to INDEX_ALIGN bytes,
+ * advancing the position. Returns the offset the section was written at,
+ * or 0 (never a valid section offset) if the write failed.
+ */
+static uint64_t write_section(FILE *out, const void *data, uint64_t size,
+        uint64_t *position) {
+    static const char padding[INDEX_ALIGN] = {0};
+    uint64_t offset = *position;
+    uint64_t padded = (size + INDEX_ALIGN - 1) / INDEX_ALIGN * INDEX_ALIGN;
+
+    if ((size && fwrite(data, 1, size, out) != size) ||
+            fwrite(padding, 1, padded - size, out) != padded - size) {
+        return 0;
+    }
+    *position += padded;
+    return offset;
+}
+
+/**
+ * The create_replacement function takes in the name of a file to replace
+ * and a pointer to the name of a temporary file. The temporary file is made
+ * in the same directory, with the permissions a new file would be given,
+ * so it can later be renamed over the original in one step.
+ * Returns the open file with its name written to tempName, or NULL if the
+ * file could not be made.
+ */
+FILE *create_replacement(const char *fileName, char **tempName) {
+    *tempName = (char *) malloc(strlen(fileName) +
+            strlen(REPLACEMENT_SUFFIX) + 1);
+    sprintf(*tempName, "%s%s", fileName, REPLACEMENT_SUFFIX);
+    int fd = mkstemp(*tempName);
+    mode_t mask = umask(0);
+    umask(mask);
+    FILE *out = NULL;
+    if (fd >= 0 && fchmod(fd, REPLACEMENT_MODE & ~mask) == 0) {
+        out = fdopen(fd, "w");
+    }
+    if (!out) {
+        if (fd >= 0) {
+            close(fd);
+            unlink(*tempName);
+        }
+        free(*tempName);
+        *tempName = NULL;
+    }
+    return out;
+}
+
+/**
+ * The commit_replacement function takes in a file made by
+ * create_replacement, its name, the name of the file it replaces, and
+ * whether everything was written to it. The file is flushed to disk and
+ * renamed over the original, so readers see either the old file or the
+ * complete new one. If anything failed the temporary file is removed and
+ * the original is left untouched.
+ * Returns 1 if the file was replaced and 0 otherwise.
+ */
+int commit_replacement(FILE *out, char *tempName, const char *fileName,
+        int ok) {
+    ok = ok && fflush(out) == 0 && fsync(fileno(out)) == 0;
+    ok = (fclose(out) == 0) && ok;
+    ok = ok && rename(tempName, fileName) == 0;
+    if (!ok) {
+        unlink(tempName);
+    }
+    free(tempName);
+    return ok;
+}
+
+/**
+ * The compile_index function takes in the name of a text dictionary and
+ * the name of the index file to create. It loads the dictionary and writes
+ * its string pool, word lengths, letter masks and counts, and the presorted
+ * -alpha and -len orderings into a single versioned file. The index is
+ * written beside the target and renamed into place, so a failed compile
+ * never leaves a broken index behind.
+ * Returns 0 on success, 2 if the dictionary cannot be read, and 5 if the
+ * index cannot be written.
+ */
+int compile_index(const char *dictName, const char *indexName) {
+    Dict *dict = load_dict(dictName);
+    if (!dict) {
+        return 2;
+    }
+    char *tempName;
+    FILE *out = create_replacement(indexName, &tempName);
+    if (!out) {
+        free_dict(dict);
+        return 5;
+    }
+
+    IndexHeader header;
+    memset(&header, 0, sizeof(IndexHeader));
+    memcpy(header.magic, INDEX_MAGIC, INDEX_MAGIC_LEN);
+    header.version = INDEX_VERSION;
+    header.wordCount = dict->wordCount;
+
+    uint32_t *alphaOrder = make_order(dict, sort_alpha);
+    uint32_t *lenOrder = make_order(dict, sort_len);
+    uint8_t *counts = pack_counts(dict);
+    uint64_t count = dict->wordCount;
+
+    // Leave room for the header, which is written once the layout is known.
+    uint64_t position = sizeof(IndexHeader);
+    int ok = fwrite(&header, sizeof(IndexHeader), 1, out) == 1;
+    header.poolSize = dict->poolSize;
+    header.poolOffset = write_section(out, dict->pool, header.poolSize,
+            &position);
+    header.offsetsOffset = write_section(out, dict->offsets,
+            count * sizeof(uint64_t), &position);
+    header.lengthsOffset = write_section(out, dict->lengths,
+            count * sizeof(int32_t), &position);
+    header.masksOffset = write_section(out, dict->masks,
+            count * sizeof(uint32_t), &position);
+    header.countsOffset = write_section(out, counts, count * ALPHABET_SIZE,
+            &position);
+    header.alphaOffset = write_section(out, alphaOrder,
+            count * sizeof(uint32_t), &position);
+    header.lenOffset = write_section(out, lenOrder,
+            count * sizeof(uint32_t), &position);
+    header.fileSize = position;
+
+    ok = ok && header.poolOffset && header.offsetsOffset &&
+            header.lengthsOffset && header.masksOffset &&
+            header.countsOffset && header.alphaOffset && header.lenOffset &&
+            fseek(out, 0, SEEK_SET) == 0 &&
+            fwrite(&header, sizeof(IndexHeader), 1, out) == 1;
+    ok = commit_replacement(out, tempName, indexName, ok);
+
+    free(alphaOrder);
+    free(lenOrder);
+    free(counts);
+    free_dict(dict);
+    return ok ? 0 : 5;
+}
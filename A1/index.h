@@ -0,0 +1,43 @@
+#ifndef _INDEX_H
+#define _INDEX_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "dict.h"
+
+// Macro Definitions
+#define INDEX_MAGIC "\177UNJIDX"
+#define INDEX_MAGIC_LEN 8
+#define INDEX_VERSION 2
+#define INDEX_ALIGN 8
+#define REPLACEMENT_SUFFIX ".XXXXXX"
+#define REPLACEMENT_MODE 0666
+
+// The header at the start of a compiled dictionary index. Every section
+// offset is relative to the start of the file and aligned to INDEX_ALIGN
+// bytes, so the sections can be used in place once the file is mapped.
+typedef struct {
+    char magic[INDEX_MAGIC_LEN];  // INDEX_MAGIC, including its terminator
+    uint32_t version;             // INDEX_VERSION of the writer
+    uint32_t wordCount;           // Number of words in the dictionary
+    uint64_t fileSize;            // Total size of the index file
+    uint64_t poolOffset;          // Null terminated word text
+    uint64_t poolSize;
+    uint64_t offsetsOffset;       // uint64_t offset of each word in the pool
+    uint64_t lengthsOffset;       // int32_t length of each word
+    uint64_t masksOffset;         // uint32_t letter mask of each word
+    uint64_t countsOffset;        // uint8_t letter counts, a column a letter
+    uint64_t alphaOffset;         // uint32_t word indices in -alpha order
+    uint64_t lenOffset;           // uint32_t word indices in -len order
+} IndexHeader;
+
+// Function Declarations
+int has_magic(const char *fileName, const char *magic, int length);
+int is_index(const char *fileName);
+Dict *load_index(const char *fileName, int copy);
+FILE *create_replacement(const char *fileName, char **tempName);
+int commit_replacement(FILE *out, char *tempName, const char *fileName,
+        int ok);
+int compile_index(const char *dictName, const char *indexName);
+
+#endif
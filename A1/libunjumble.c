@@ -0,0 +1,132 @@
+/**
+ * Author: Ethan Pinto
+ * Student Number: s4642286
+ * Program Name: unjumble
+ * File Name: libunjumble.c
+**/
+
+#include "libunjumble.h"
+#include "dict.h"
+#include "filter.h"
+#include "sort.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The order_words order for each UNJUMBLE_ORDER macro.
+static const int orders[] = {ORDER_NONE, ORDER_ALPHA, ORDER_LEN,
+        ORDER_LONGEST};
+
+// The dictionary a program has loaded, and how to filter it.
+struct UnjumbleContext {
+    Dict *dict;             // The loaded dictionary
+    int threads;            // Number of threads each query is filtered on
+};
+
+/**
+ * The unjumble_open function takes in the name of a text dictionary or a
+ * compiled index, and the number of threads to filter each query on (less
+ * than 1 for one thread). The dictionary is loaded once and kept for
+ * every query run against the context. A DAWG is not accepted, as it can
+ * only be searched from the command line.
+ * Returns the new context, or NULL if the dictionary cannot be opened or
+ * is a DAWG.
+ */
+UnjumbleContext *unjumble_open(const char *dictName, int threads) {
+    UnjumbleContext *context = (UnjumbleContext *) malloc(
+            sizeof(UnjumbleContext));
+    if (!context) {
+        return NULL;
+    }
+    context->dict = load_dict(dictName);
+    if (!context->dict) {
+        free(context);
+        return NULL;
+    }
+    context->threads = threads < 1 ? 1 : threads > MAX_THREADS ?
+            MAX_THREADS : threads;
+    return context;
+}
+
+/**
+ * The unjumble_query function takes in a context, the letters to unjumble
+ * (which may hold ? blank tiles), a letter every word must contain (or
+ * '\0' for none), one of the UNJUMBLE_ORDER macros, and a callback along
+ * with data to pass to it. Every dictionary word that can be made from the
+ * letters is passed to the callback in the given order, exactly as the
+ * command line would print them, until the callback asks to stop.
+ * Returns the number of words passed to the callback, or one of the
+ * UNJUMBLE_ERR macros if the query is not valid or memory for it could not
+ * be allocated. Nothing is exited on.
+ */
+int unjumble_query(UnjumbleContext *context, const char *letters,
+        char include, int order, UnjumbleCallback callback, void *data) {
+    if (!letters || strlen(letters) < MIN_WORD_LEN) {
+        return UNJUMBLE_ERR_FEW_LETTERS;
+    } else if (letters_check(letters) == -1) {
+        return UNJUMBLE_ERR_NON_ALPHA;
+    } else if ((include && !isalpha(include)) ||
+            order < UNJUMBLE_ORDER_NONE || order > UNJUMBLE_ORDER_LONGEST) {
+        return UNJUMBLE_ERR_USAGE;
+    }
+    order = orders[order];
+    Dict *dict = context->dict;
+    uint32_t *words = (uint32_t *) malloc(sizeof(uint32_t) *
+            (dict->wordCount ? dict->wordCount : 1));
+    if (!words) {
+        return UNJUMBLE_ERR_MEMORY;
+    }
+
+    // Scan a compiled index in the order asked for, if it has one.
+    const uint32_t *scan = NULL;
+    if (order == ORDER_ALPHA) {
+        scan = dict->alphaOrder;
+    } else if (order != ORDER_NONE) {
+        scan = dict->lenOrder;
+    }
+    char includeArg[] = {include, '\0'};
+    Query query;
+    prepare_query(&query, letters, include ? includeArg : NULL);
+    query.longest = order == ORDER_LONGEST;
+    int wordCount = filter_words(dict, &query, scan, context->threads,
+            words);
+    wordCount = order_words(dict, order, words, wordCount, scan != NULL);
+
+    int passed = 0;
+    while (passed < wordCount) {
+        uint32_t word = words[passed++];
+        if (callback(dict_word(dict, word), dict->lengths[word], data)) {
+            break;
+        }
+    }
+    free(words);
+    return passed;
+}
+
+/**
+ * Takes in a status returned by unjumble_query, and returns the message
+ * the command line prints for it, or a description of an error only the
+ * library reports.
+ */
+const char *unjumble_error(int status) {
+    if (status == UNJUMBLE_ERR_FEW_LETTERS) {
+        return "unjumble: must supply at least three letters";
+    } else if (status == UNJUMBLE_ERR_NON_ALPHA) {
+        return "unjumble: can only unjumble alphabetic characters";
+    } else if (status == UNJUMBLE_ERR_USAGE) {
+        return "unjumble: invalid query";
+    } else if (status == UNJUMBLE_ERR_MEMORY) {
+        return "unjumble: out of memory";
+    }
+    return "unjumble: no error";
+}
+
+/**
+ * Takes in a context and releases its dictionary. Returns nothing.
+ */
+void unjumble_close(UnjumbleContext *context) {
+    if (context) {
+        free_dict(context->dict);
+        free(context);
+    }
+}
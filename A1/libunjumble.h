@@ -0,0 +1,30 @@
+#ifndef _LIBUNJUMBLE_H
+#define _LIBUNJUMBLE_H
+
+// Macro Definitions
+#define UNJUMBLE_ORDER_NONE 0       // Dictionary order
+#define UNJUMBLE_ORDER_ALPHA 1      // As with -alpha
+#define UNJUMBLE_ORDER_LEN 2        // As with -len
+#define UNJUMBLE_ORDER_LONGEST 3    // As with -longest
+#define UNJUMBLE_ERR_USAGE -1       // Invalid include letter or order
+#define UNJUMBLE_ERR_FEW_LETTERS -3 // Fewer than three letters
+#define UNJUMBLE_ERR_NON_ALPHA -4   // Letters other than letters and blanks
+#define UNJUMBLE_ERR_MEMORY -8      // The query could not allocate memory
+
+// A loaded dictionary that any number of queries can be run against, from
+// any number of threads at once.
+typedef struct UnjumbleContext UnjumbleContext;
+
+// Called once for each matching word, in order. The word is null
+// terminated and stays valid until the context is closed. Returns 0 to
+// keep receiving words, or anything else to stop the query.
+typedef int (*UnjumbleCallback)(const char *word, int length, void *data);
+
+// Function Declarations
+UnjumbleContext *unjumble_open(const char *dictName, int threads);
+int unjumble_query(UnjumbleContext *context, const char *letters,
+        char include, int order, UnjumbleCallback callback, void *data);
+const char *unjumble_error(int status);
+void unjumble_close(UnjumbleContext *context);
+
+#endif
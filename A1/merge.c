@@ -0,0 +1,266 @@
+/**
+ * Author: Ethan Pinto
+ * Student Number: s4642286
+ * Program Name: unjumble
+ * File Name: merge.c
+**/
+
+#define _GNU_SOURCE
+#include "merge.h"
+#include "sort.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+/**
+ * Takes in a run to fill in, a dictionary, and an array of word indices
+ * into it in the run's order and its length. The run reads its words
+ * straight from the dictionary. Returns nothing.
+ */
+void memory_run(Run *run, const Dict *dict, const uint32_t *words,
+        int wordCount) {
+    run->file = NULL;
+    run->dict = dict;
+    run->words = words;
+    run->wordCount = wordCount;
+}
+
+/**
+ * Takes in a merge and the position of one of its runs, and reads the
+ * run's next word, scoring it if the runs are ranked. The run's word is
+ * set to NULL once every word has been read. Returns nothing.
+ */
+static void next_word(Merge *merge, int position) {
+    Run *run = &merge->runs[position];
+    if (!run->file) {
+        if (run->next == run->wordCount) {
+            run->word = NULL;
+            return;
+        }
+        uint32_t index = run->words[run->next++];
+        run->word = dict_word(run->dict, index);
+        run->length = run->dict->lengths[index];
+    } else {
+        ssize_t length = getline(&run->word, &run->wordSize, run->file);
+        if (length < 0) {
+            free(run->word);
+            run->word = NULL;
+            return;
+        }
+        if (length && run->word[length - 1] == '\n') {
+            run->word[--length] = '\0';
+        }
+        run->length = (int)length;
+    }
+    if (merge->ranking && merge->ranking->scored) {
+        run->score = text_score(merge->ranking, run->word);
+    }
+}
+
+/**
+ * The run_cmp function takes in a merge and the positions of two runs
+ * that both have a word left. The words are compared the way the words of
+ * one dictionary are: by rank, by descending length or alphabetically, as
+ * the merge's order asks. Words that tie are taken from the earlier run
+ * first, so runs made in dictionary order are joined in that order.
+ * Returns a negative number if the first run's word comes first, and a
+ * positive number otherwise.
+ */
+static int run_cmp(const Merge *merge, int position1, int position2) {
+    const Run *run1 = &merge->runs[position1];
+    const Run *run2 = &merge->runs[position2];
+    int result = 0;
+    if (merge->ranking && merge->ranking->scored &&
+            run1->score != run2->score) {
+        return run1->score > run2->score ? -1 : 1;
+    }
+    // Ranked words are in -len order once their scores tie.
+    int ranked = merge->ranking != NULL;
+    if ((ranked || merge->order == ORDER_LEN ||
+            merge->order == ORDER_LONGEST) && run1->length != run2->length) {
+        return run1->length > run2->length ? -1 : 1;
+    }
+    if (ranked || merge->order != ORDER_NONE) {
+        result = strcasecmp(run1->word, run2->word);
+        if (result == 0) {
+            result = strcmp(run1->word, run2->word);
+        }
+    }
+    return result ? result : position1 - position2;
+}
+
+/**
+ * Takes in a merge, a heap of run positions and its size, and the place
+ * of an entry that may come after its children. Moves the entry down
+ * until the run with the first word is at the top. Returns nothing.
+ */
+static void sift_down(const Merge *merge, int *heap, int heapSize,
+        int place) {
+    while (1) {
+        int first = place;
+        for (int child = 2 * place + 1; child <= 2 * place + 2 &&
+                child < heapSize; child++) {
+            if (run_cmp(merge, heap[child], heap[first]) < 0) {
+                first = child;
+            }
+        }
+        if (first == place) {
+            return;
+        }
+        int swap = heap[place];
+        heap[place] = heap[first];
+        heap[first] = swap;
+        place = first;
+    }
+}
+
+/**
+ * The merge_runs function takes in a merge, the most words to write (0 for
+ * no limit), the character to end each word with and the output stream.
+ * It writes the words of every run in the merge's order, always taking
+ * the first of the runs' next words, which a heap of the runs keeps at
+ * its top. Equal words are next to each other in that order, so for a
+ * unique merge a word equal to the last one written is skipped. For
+ * -longest only the words as long as the first are written. Every spilled
+ * run is closed. Returns the number of words written, or -1 if the output
+ * could not be written.
+ */
+long merge_runs(Merge *merge, long limit, char delimiter, FILE *output) {
+    int *heap = (int *) malloc(sizeof(int) * (merge->runCount + 1));
+    int heapSize = 0;
+    for (int i = 0; i < merge->runCount; i++) {
+        Run *run = &merge->runs[i];
+        run->next = 0;
+        run->word = NULL;
+        run->wordSize = 0;
+        if (run->file) {
+            rewind(run->file);
+        }
+        next_word(merge, i);
+        if (run->word) {
+            heap[heapSize++] = i;
+        }
+    }
+    for (int place = heapSize / 2 - 1; place >= 0; place--) {
+        sift_down(merge, heap, heapSize, place);
+    }
+
+    long written = 0;
+    int longest = -1;
+    char *last = NULL;
+    size_t lastSize = 0;
+    while (heapSize && (!limit || written < limit)) {
+        Run *run = &merge->runs[heap[0]];
+        if (merge->order == ORDER_LONGEST && longest < 0) {
+            longest = run->length;
+        } else if (merge->order == ORDER_LONGEST && run->length < longest) {
+            break;
+        }
+        if (!merge->unique || !last || strcmp(last, run->word) != 0) {
+            fwrite(run->word, 1, run->length, output);
+            putc(delimiter, output);
+            written++;
+            if (merge->unique) {
+                if (lastSize < (size_t)run->length + 1) {
+                    lastSize = run->length + 1;
+                    last = (char *) realloc(last, lastSize);
+                }
+                memcpy(last, run->word, run->length + 1);
+            }
+        }
+        next_word(merge, heap[0]);
+        if (!run->word) {
+            heap[0] = heap[--heapSize];
+        }
+        sift_down(merge, heap, heapSize, 0);
+    }
+    for (int i = 0; i < merge->runCount; i++) {
+        if (merge->runs[i].file) {
+            free(merge->runs[i].word);
+            fclose(merge->runs[i].file);
+        }
+    }
+    free(last);
+    free(heap);
+    return fflush(output) == 0 && !ferror(output) ? written : -1;
+}
+
+/**
+ * The reduce_runs function takes in a merge of more than MERGE_FAN_IN
+ * spilled runs and the most words any run needs to hold (0 for no limit).
+ * Each MERGE_FAN_IN consecutive runs are merged into one new run, in
+ * order, until few enough are left to be merged at once. This keeps the
+ * number of open files bounded however large the dictionary is.
+ * Returns 0 on success, and -1 if a run could not be written.
+ */
+int reduce_runs(Merge *merge, long limit) {
+    while (merge->runCount > MERGE_FAN_IN) {
+        Merge part = *merge;
+        int reduced = 0;
+        for (int start = 0; start < merge->runCount; start += MERGE_FAN_IN) {
+            part.runs = merge->runs + start;
+            part.runCount = merge->runCount - start < MERGE_FAN_IN ?
+                    merge->runCount - start : MERGE_FAN_IN;
+            FILE *run = tmpfile();
+            if (!run || merge_runs(&part, limit, '\n', run) < 0) {
+                for (int i = 0; i < reduced; i++) {
+                    fclose(merge->runs[i].file);
+                }
+                if (run) {
+                    fclose(run);
+                }
+                // Close the runs that were never merged.
+                for (int i = run ? start + part.runCount : start;
+                        i < merge->runCount; i++) {
+                    fclose(merge->runs[i].file);
+                }
+                merge->runCount = 0;
+                return -1;
+            }
+            merge->runs[reduced++].file = run;
+        }
+        merge->runCount = reduced;
+    }
+    return 0;
+}
+
+/**
+ * Takes in the argument structs of a -groups query, the merge of its runs,
+ * the most words to keep (0 for no limit), the output stream and the
+ * query's stats (or NULL). The matching words are merged back into
+ * memory, since an anagram class may span every run, and written in
+ * groups. Only the matches are held, so a -mem query grouping a whole
+ * dictionary is refused as a usage error rather than streamed here.
+ * Returns the number of words written, or -1 if the merged words could
+ * not be spilled or written.
+ */
+long merge_groups(ArgType **argStructs, Merge *merge, long limit,
+        FILE *output, QueryStats *stats) {
+    FILE *merged = tmpfile();
+    if (!merged || merge_runs(merge, limit, '\n', merged) < 0) {
+        if (merged) {
+            fclose(merged);
+        }
+        return -1;
+    }
+    rewind(merged);
+    Dict *arena = new_arena();
+    char *line = NULL;
+    size_t lineSize = 0;
+    ssize_t length;
+    while ((length = getline(&line, &lineSize, merged)) > 0) {
+        arena_add(arena, line, length - 1);
+    }
+    free(line);
+    fclose(merged);
+    uint32_t *words = (uint32_t *) malloc(sizeof(uint32_t) *
+            (arena->wordCount ? arena->wordCount : 1));
+    for (int i = 0; i < arena->wordCount; i++) {
+        words[i] = i;
+    }
+    long written = write_output(argStructs, arena, words, arena->wordCount,
+            output, stats);
+    free(words);
+    free_dict(arena);
+    return written;
+}
@@ -0,0 +1,43 @@
+#ifndef _MERGE_H
+#define _MERGE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "unjumble.h"
+
+// Macro Definitions
+#define MERGE_FAN_IN 64
+
+// A sorted run of matching words, along with the word at its head while
+// it is being merged. A run is either spilled to a temporary file, one
+// word per line, or held in memory as word indices into a dictionary.
+typedef struct {
+    FILE *file;             // The spilled run, or NULL if it is in memory
+    const Dict *dict;       // Dictionary of a run held in memory
+    const uint32_t *words;  // Word indices of a run held in memory
+    int wordCount;          // Number of words in a run held in memory
+    int next;               // Place of the next word in a run in memory
+    char *word;             // The run's next word, or NULL once used up
+    size_t wordSize;        // Room in word, for a spilled run
+    int length;             // Length of the next word
+    long score;             // Letter value of the next word, if ranked
+} Run;
+
+// The runs being merged into one, and the order they are sorted in.
+typedef struct {
+    Run *runs;              // The runs, in the order they were made
+    int runCount;           // Number of runs
+    int order;              // One of the ORDER macros
+    const Ranking *ranking; // The ranking of a -top query, or NULL
+    int unique;             // True if a word is written only once
+} Merge;
+
+// Function Declarations
+void memory_run(Run *run, const Dict *dict, const uint32_t *words,
+        int wordCount);
+long merge_runs(Merge *merge, long limit, char delimiter, FILE *output);
+int reduce_runs(Merge *merge, long limit);
+long merge_groups(ArgType **argStructs, Merge *merge, long limit,
+        FILE *output, QueryStats *stats);
+
+#endif
@@ -0,0 +1,138 @@
+/**
+ * Author: Ethan Pinto
+ * Student Number: s4642286
+ * Program Name: unjumble
+ * File Name: output.c
+**/
+
+#include "output.h"
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+/**
+ * Takes in a file descriptor and an array of buffers, and writes all of
+ * them, retrying after partial writes and interruptions.
+ * Returns 0 on success, and -1 if the write failed.
+ */
+static int write_all(int fd, struct iovec *parts, int partCount) {
+    while (partCount > 0) {
+        ssize_t written = writev(fd, parts, partCount);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        // Skip the parts that were written in full.
+        while (partCount > 0 && (size_t)written >= parts->iov_len) {
+            written -= parts->iov_len;
+            parts++;
+            partCount--;
+        }
+        if (partCount > 0) {
+            parts->iov_base = (char *)parts->iov_base + written;
+            parts->iov_len -= written;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Takes in an output buffer, and a word too long to be copied into it
+ * along with its delimiter. Writes whatever is waiting in the buffer and
+ * then the word in a single call. Returns nothing.
+ */
+static void flush_buffer(OutputBuffer *buffer, const char *word,
+        size_t length, char *delimiter) {
+    struct iovec parts[3];
+    int partCount = 0;
+    if (buffer->used) {
+        parts[partCount].iov_base = buffer->data;
+        parts[partCount++].iov_len = buffer->used;
+    }
+    if (word) {
+        parts[partCount].iov_base = (char *)word;
+        parts[partCount++].iov_len = length;
+        parts[partCount].iov_base = delimiter;
+        parts[partCount++].iov_len = 1;
+    }
+    if (!buffer->failed && write_all(buffer->fd, parts, partCount) < 0) {
+        // Nobody is reading any more, so don't keep trying.
+        buffer->failed = 1;
+    }
+    buffer->used = 0;
+}
+
+/**
+ * Takes in an output buffer, a word and its length, and the character to
+ * end the word with, and copies both into the buffer. The buffer is
+ * written out first if they do not fit, and a word too long to be worth
+ * copying is written straight from the pool. Returns nothing.
+ */
+static void buffer_word(OutputBuffer *buffer, const char *word,
+        size_t length, char end) {
+    if (buffer->used + length + 1 > OUTPUT_BUFFER_SIZE) {
+        if (length + 1 > OUTPUT_BUFFER_SIZE / 2) {
+            flush_buffer(buffer, word, length, &end);
+            return;
+        }
+        flush_buffer(buffer, NULL, 0, NULL);
+    }
+    memcpy(buffer->data + buffer->used, word, length);
+    buffer->data[buffer->used + length] = end;
+    buffer->used += length + 1;
+}
+
+/**
+ * The write_words function takes in a dictionary, an array of word
+ * indices and its length, the character to end each word with, and the
+ * output stream. Anything the stream has buffered is flushed first, then
+ * the words are copied straight from the dictionary's pool into one large
+ * buffer that is written to the stream's file descriptor whenever it
+ * fills. Returns 0 on success, and -1 if any of the words could not be
+ * written.
+ */
+int write_words(Dict *dict, const uint32_t *words, int wordCount,
+        char delimiter, FILE *output) {
+    OutputBuffer buffer;
+    buffer.fd = fileno(output);
+    buffer.used = 0;
+    buffer.failed = 0;
+    fflush(output);
+
+    for (int i = 0; i < wordCount; i++) {
+        buffer_word(&buffer, dict_word(dict, words[i]),
+                dict->lengths[words[i]], delimiter);
+    }
+    flush_buffer(&buffer, NULL, 0, NULL);
+    return buffer.failed ? -1 : 0;
+}
+
+/**
+ * The write_groups function takes in a dictionary, an array of word
+ * indices arranged into groups, the start of each group followed by the
+ * number of words, the number of groups, the character to end each group
+ * with, and the output stream. The words of each group are written on one
+ * line, separated by spaces, through the same buffer as write_words.
+ * Returns 0 on success, and -1 if any of the words could not be written.
+ */
+int write_groups(Dict *dict, const uint32_t *words, const int *groupStarts,
+        int groupCount, char delimiter, FILE *output) {
+    OutputBuffer buffer;
+    buffer.fd = fileno(output);
+    buffer.used = 0;
+    buffer.failed = 0;
+    fflush(output);
+
+    for (int g = 0; g < groupCount; g++) {
+        for (int i = groupStarts[g]; i < groupStarts[g + 1]; i++) {
+            buffer_word(&buffer, dict_word(dict, words[i]),
+                    dict->lengths[words[i]],
+                    i + 1 < groupStarts[g + 1] ? GROUP_SEPARATOR : delimiter);
+        }
+    }
+    flush_buffer(&buffer, NULL, 0, NULL);
+    return buffer.failed ? -1 : 0;
+}
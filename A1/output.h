@@ -0,0 +1,26 @@
+#ifndef _OUTPUT_H
+#define _OUTPUT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "dict.h"
+
+// Macro Definitions
+#define OUTPUT_BUFFER_SIZE 65536
+#define GROUP_SEPARATOR ' '
+
+// Words waiting to be written to a file descriptor in one system call.
+typedef struct {
+    int fd;                             // Where the words are written
+    size_t used;                        // Bytes of data waiting
+    int failed;                         // True once a write has failed
+    char data[OUTPUT_BUFFER_SIZE];
+} OutputBuffer;
+
+// Function Declarations
+int write_words(Dict *dict, const uint32_t *words, int wordCount,
+        char delimiter, FILE *output);
+int write_groups(Dict *dict, const uint32_t *words, const int *groupStarts,
+        int groupCount, char delimiter, FILE *output);
+
+#endif
@@ -0,0 +1,185 @@
+/**
+ * Author: Ethan Pinto
+ * Student Number: s4642286
+ * Program Name: unjumble
+ * File Name: pattern.c
+**/
+
+#include "pattern.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+// Guards building bitmaps, which server threads may ask for at once.
+static pthread_mutex_t patternLock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Takes in a pattern argument and checks that it has at least MIN_WORD_LEN
+ * characters, each a letter or a blank tile.
+ * Returns 1 if the pattern is valid, and -1 otherwise.
+ */
+int pattern_check(const char *pattern) {
+    int length = 0;
+    for (; pattern[length]; length++) {
+        if (letter_index(pattern[length]) < 0 &&
+                pattern[length] != BLANK_TILE) {
+            return -1;
+        }
+    }
+    return length >= MIN_WORD_LEN ? 1 : -1;
+}
+
+/**
+ * The build_length function takes in a dictionary and a word length, and
+ * builds the positional bitmaps of every word of that length made only of
+ * letters, in one pass over the words. Returns the bitmaps.
+ */
+static LengthIndex *build_length(const Dict *dict, int length) {
+    LengthIndex *index = (LengthIndex *) calloc(1, sizeof(LengthIndex));
+    for (int i = 0; i < dict->wordCount; i++) {
+        index->wordCount += dict->lengths[i] == length &&
+                !(dict->masks[i] & NON_ALPHA_BIT);
+    }
+    index->words = (uint32_t *) malloc(sizeof(uint32_t) *
+            (index->wordCount + 1));
+    index->blockCount = (index->wordCount + BITMAP_WORD_BITS - 1) /
+            BITMAP_WORD_BITS;
+    index->bits = (uint64_t *) calloc((size_t)length * ALPHABET_SIZE *
+            index->blockCount + 1, sizeof(uint64_t));
+
+    int k = 0;
+    for (int i = 0; i < dict->wordCount; i++) {
+        if (dict->lengths[i] != length || (dict->masks[i] & NON_ALPHA_BIT)) {
+            continue;
+        }
+        const char *word = dict_word(dict, i);
+        for (int position = 0; position < length; position++) {
+            size_t bitmap = (size_t)position * ALPHABET_SIZE +
+                    letter_index(word[position]);
+            index->bits[bitmap * index->blockCount + k / BITMAP_WORD_BITS] |=
+                    (uint64_t)1 << (k % BITMAP_WORD_BITS);
+        }
+        index->words[k++] = i;
+    }
+    return index;
+}
+
+/**
+ * Takes in a dictionary and a word length, and returns the positional
+ * bitmaps of that length, building them if this is the first time they
+ * have been needed. Returns NULL if no word is that long.
+ */
+static LengthIndex *length_index(Dict *dict, int length) {
+    pthread_mutex_lock(&patternLock);
+    if (!dict->patterns) {
+        dict->patterns = (PatternIndex *) calloc(1, sizeof(PatternIndex));
+        for (int i = 0; i < dict->wordCount; i++) {
+            if (dict->lengths[i] > dict->patterns->maxLength) {
+                dict->patterns->maxLength = dict->lengths[i];
+            }
+        }
+        dict->patterns->lengths = (LengthIndex **) calloc(
+                dict->patterns->maxLength + 1, sizeof(LengthIndex *));
+    }
+    LengthIndex *index = NULL;
+    if (length <= dict->patterns->maxLength) {
+        if (!dict->patterns->lengths[length]) {
+            dict->patterns->lengths[length] = build_length(dict, length);
+        }
+        index = dict->patterns->lengths[length];
+    }
+    pthread_mutex_unlock(&patternLock);
+    return index;
+}
+
+/**
+ * The pattern_words function takes in a dictionary, a pattern of letters
+ * and blank tiles, a prepared query and an index array with room for
+ * every word. The words of the pattern's length with the pattern's letter
+ * at each of its fixed positions are found by ANDing one bitmap per fixed
+ * position. Those that also fit the query's letters (if it has any) and
+ * contain its -include letter are compacted into the array in dictionary
+ * order. Only the words that match the pattern are counted as scanned.
+ * Returns the number of matching words.
+ */
+int pattern_words(Dict *dict, const char *pattern, const Query *query,
+        uint32_t *matches) {
+    int length = strlen(pattern);
+    LengthIndex *index = length_index(dict, length);
+    if (!index || !index->wordCount) {
+        return 0;
+    }
+
+    // Start from every word of the length, then narrow by position.
+    uint64_t *result = (uint64_t *) malloc(sizeof(uint64_t) *
+            index->blockCount);
+    memset(result, 0xff, sizeof(uint64_t) * index->blockCount);
+    if (index->wordCount % BITMAP_WORD_BITS) {
+        result[index->blockCount - 1] = ((uint64_t)1 <<
+                (index->wordCount % BITMAP_WORD_BITS)) - 1;
+    }
+    for (int position = 0; position < length; position++) {
+        if (pattern[position] == BLANK_TILE) {
+            continue;
+        }
+        const uint64_t *bitmap = index->bits + ((size_t)position *
+                ALPHABET_SIZE + letter_index(pattern[position])) *
+                index->blockCount;
+        for (int block = 0; block < index->blockCount; block++) {
+            result[block] &= bitmap[block];
+        }
+    }
+
+    int matchCount = 0;
+    for (int block = 0; block < index->blockCount; block++) {
+        for (uint64_t bits = result[block]; bits; bits &= bits - 1) {
+            int i = index->words[block * BITMAP_WORD_BITS +
+                    __builtin_ctzll(bits)];
+            int kind = -1;
+            if (query->letters && length > query->lettersLen) {
+                kind = REJECT_LENGTH;
+            } else if (query->includeBit && has_single_letter(
+                    query->includeBit, dict->masks[i]) == -1) {
+                kind = REJECT_INCLUDE;
+            } else if (query->letters && (word_fits(dict, i,
+                    &query->lettersSig, query->blanks) == -1 ||
+                    ((dict->masks[i] & OVERFLOW_BIT) &&
+                    exact_fit(dict_word(dict, i), query->letters) == -1))) {
+                kind = REJECT_LETTERS;
+            }
+            if (query->stats) {
+                query->stats->scanned++;
+                if (kind >= 0) {
+                    query->stats->rejected[kind]++;
+                }
+            }
+            if (kind < 0) {
+                matches[matchCount++] = i;
+            }
+        }
+    }
+    free(result);
+    if (query->stats) {
+        query->stats->matched += matchCount;
+    }
+    return matchCount;
+}
+
+/**
+ * Takes in the positional bitmaps of a dictionary (or NULL) and frees
+ * every length that was built. Returns nothing.
+ */
+void free_patterns(PatternIndex *patterns) {
+    if (!patterns) {
+        return;
+    }
+    for (int length = 0; length <= patterns->maxLength; length++) {
+        if (patterns->lengths[length]) {
+            free(patterns->lengths[length]->words);
+            free(patterns->lengths[length]->bits);
+            free(patterns->lengths[length]);
+        }
+    }
+    free(patterns->lengths);
+    free(patterns);
+}
@@ -0,0 +1,34 @@
+#ifndef _PATTERN_H
+#define _PATTERN_H
+
+#include <stdint.h>
+#include "dict.h"
+#include "filter.h"
+
+// Macro Definitions
+#define BITMAP_WORD_BITS 64
+
+// The positional bitmaps of every word of one length. Bit k of the bitmap
+// for a position and letter is set if the k-th word has that letter
+// there.
+typedef struct {
+    int wordCount;          // Number of words of the length
+    uint32_t *words;        // Their dictionary indices, in dictionary order
+    int blockCount;         // 64-bit blocks in each bitmap
+    uint64_t *bits;         // Bitmaps, by position, then letter, then block
+} LengthIndex;
+
+// The positional bitmaps of a dictionary, built for a length the first
+// time a pattern of that length is queried and kept for later queries.
+struct PatternIndex {
+    int maxLength;          // Length of the longest word
+    LengthIndex **lengths;  // Bitmaps of each length, or NULL if not built
+};
+
+// Function Declarations
+int pattern_check(const char *pattern);
+int pattern_words(Dict *dict, const char *pattern, const Query *query,
+        uint32_t *matches);
+void free_patterns(PatternIndex *patterns);
+
+#endif
@@ -0,0 +1,461 @@
+/**
+ * Author: Ethan Pinto
+ * Student Number: s4642286
+ * Program Name: unjumble
+ * File Name: phrase.c
+**/
+
+#include "phrase.h"
+#include "dict.h"
+#include "filter.h"
+#include "output.h"
+#include "sort.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* CANDIDATE FUNCTIONS */
+
+/**
+ * Takes in letter counts and the lowest class a state may use, and returns
+ * a hash of them for the memo table.
+ */
+static uint32_t state_hash(const uint8_t *counts, int minClass) {
+    uint32_t hash = 2166136261u ^ (uint32_t)minClass;
+    for (int i = 0; i < ALPHABET_SIZE; i++) {
+        hash = (hash ^ counts[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * The make_classes function takes in the phrase search and the indices of
+ * the candidate words in -alpha order with repeats removed. Words with the
+ * same letter counts are grouped into one anagram class, numbered in order
+ * of their first word, and the members array holds each class's words
+ * together, in -alpha order. Returns nothing.
+ */
+static void make_classes(PhraseSearch *search, const uint32_t *words,
+        int wordCount) {
+    // Find the class of every word with a hash table of class numbers.
+    int tableCap = 1;
+    while (tableCap < 2 * wordCount + 1) {
+        tableCap *= 2;
+    }
+    int *table = (int *) malloc(sizeof(int) * tableCap);
+    memset(table, -1, sizeof(int) * tableCap);
+    int *wordClass = (int *) malloc(sizeof(int) * (wordCount + 1));
+    search->classes = (AnagramClass *) calloc(wordCount + 1,
+            sizeof(AnagramClass));
+    search->classCount = 0;
+
+    for (int w = 0; w < wordCount; w++) {
+        Signature sig;
+        make_signature(dict_word(search->dict, words[w]),
+                search->dict->lengths[words[w]], &sig);
+        uint32_t slot = state_hash(sig.counts, 0) & (tableCap - 1);
+        while (table[slot] >= 0 && memcmp(search->classes[table[slot]].sig
+                .counts, sig.counts, ALPHABET_SIZE) != 0) {
+            slot = (slot + 1) & (tableCap - 1);
+        }
+        if (table[slot] < 0) {
+            AnagramClass *class = &search->classes[search->classCount];
+            class->sig = sig;
+            class->length = search->dict->lengths[words[w]];
+            table[slot] = search->classCount++;
+        }
+        wordClass[w] = table[slot];
+        search->classes[wordClass[w]].count++;
+    }
+
+    // Lay the classes out one after another, keeping the words in order.
+    int position = 0;
+    for (int c = 0; c < search->classCount; c++) {
+        search->classes[c].first = position;
+        position += search->classes[c].count;
+        search->classes[c].count = 0;
+    }
+    search->members = (uint32_t *) malloc(sizeof(uint32_t) *
+            (wordCount + 1));
+    for (int w = 0; w < wordCount; w++) {
+        AnagramClass *class = &search->classes[wordClass[w]];
+        search->members[class->first + class->count++] = words[w];
+    }
+    free(wordClass);
+    free(table);
+}
+
+/**
+ * Takes in the phrase search and the number of letters given. Marks every
+ * number of letters up to it that can be made up of the lengths of the
+ * classes, so a search never continues with a remainder no combination of
+ * words is long enough, or short enough, to fill. Returns nothing.
+ */
+static void make_reachable(PhraseSearch *search, int lettersLen) {
+    // Bucket the class lengths so each length is tried once.
+    char *hasLength = (char *) calloc(lettersLen + 1, 1);
+    for (int c = 0; c < search->classCount; c++) {
+        hasLength[search->classes[c].length] = 1;
+    }
+    search->reachable = (char *) calloc(lettersLen + 1, 1);
+    search->reachable[0] = 1;
+    for (int total = 1; total <= lettersLen; total++) {
+        for (int length = MIN_WORD_LEN; length <= total &&
+                !search->reachable[total]; length++) {
+            search->reachable[total] = hasLength[length] &&
+                    search->reachable[total - length];
+        }
+    }
+    free(hasLength);
+}
+
+/* SEARCH FUNCTIONS */
+
+/**
+ * Takes in the remaining letters and their number, a class and the number
+ * of letters that will be left. Returns 1 if the class's words can be
+ * taken from the letters and what is left could still be filled, and 0
+ * otherwise.
+ */
+static int class_fits(const PhraseSearch *search, const uint8_t *remaining,
+        const AnagramClass *class, int left) {
+    if (left < 0 || !search->reachable[left]) {
+        return 0;
+    }
+    for (int i = 0; i < ALPHABET_SIZE; i++) {
+        if (class->sig.counts[i] > remaining[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Takes in the phrase search, a depth, the candidate classes of the depth
+ * above, the letters remaining and their number, and the lowest class
+ * that may be used. Fills in the candidate classes of the depth: those at
+ * or above the lowest class that fit the letters. Returns their number.
+ */
+static int narrow(PhraseSearch *search, int depth, const int *parent,
+        int parentCount, const uint8_t *remaining, int remainingLen,
+        int minClass) {
+    int *level = search->levels[depth];
+    int count = 0;
+    for (int n = 0; n < parentCount; n++) {
+        const AnagramClass *class = &search->classes[parent[n]];
+        if (parent[n] >= minClass && class_fits(search, remaining, class,
+                remainingLen - class->length)) {
+            level[count++] = parent[n];
+        }
+    }
+    return count;
+}
+
+/**
+ * Takes in the phrase search, and grows its memo table to twice the size,
+ * re-inserting every entry. Returns nothing.
+ */
+static void grow_memo(PhraseSearch *search) {
+    MemoEntry *old = search->memo;
+    size_t oldCap = search->memoCap;
+    search->memoCap = oldCap ? oldCap * 2 : INITIAL_MEMO;
+    search->memo = (MemoEntry *) calloc(search->memoCap, sizeof(MemoEntry));
+    for (size_t i = 0; i < oldCap; i++) {
+        if (!old[i].used) {
+            continue;
+        }
+        size_t slot = state_hash(old[i].counts, old[i].minClass) &
+                (search->memoCap - 1);
+        while (search->memo[slot].used) {
+            slot = (slot + 1) & (search->memoCap - 1);
+        }
+        search->memo[slot] = old[i];
+    }
+    free(old);
+}
+
+/**
+ * Takes in the phrase search, letter counts and the lowest class a state
+ * may use. Returns the memo entry for the state, adding an empty one (with
+ * used set to 0) if it has not been searched yet.
+ */
+static MemoEntry *memo_entry(PhraseSearch *search, const uint8_t *counts,
+        int minClass) {
+    if (2 * (search->memoCount + 1) > search->memoCap) {
+        grow_memo(search);
+    }
+    size_t slot = state_hash(counts, minClass) & (search->memoCap - 1);
+    while (search->memo[slot].used) {
+        MemoEntry *entry = &search->memo[slot];
+        if (entry->minClass == minClass &&
+                memcmp(entry->counts, counts, ALPHABET_SIZE) == 0) {
+            return entry;
+        }
+        slot = (slot + 1) & (search->memoCap - 1);
+    }
+    memcpy(search->memo[slot].counts, counts, ALPHABET_SIZE);
+    search->memo[slot].minClass = minClass;
+    return &search->memo[slot];
+}
+
+/**
+ * The solvable function takes in the phrase search, a depth, the
+ * candidate classes of the depth above, the letters remaining and their
+ * number, and the lowest class that may be used. Returns 1 if the letters
+ * can be used up exactly by classes at or above the lowest one, and 0
+ * otherwise. Each state is only ever searched once.
+ */
+static int solvable(PhraseSearch *search, int depth, const int *parent,
+        int parentCount, uint8_t *remaining, int remainingLen, int minClass) {
+    if (remainingLen == 0) {
+        return 1;
+    }
+    MemoEntry *entry = memo_entry(search, remaining, minClass);
+    if (entry->used) {
+        return entry->solvable;
+    }
+
+    int result = 0;
+    int count = narrow(search, depth, parent, parentCount, remaining,
+            remainingLen, minClass);
+    const int *level = search->levels[depth];
+    for (int n = 0; n < count && !result; n++) {
+        const AnagramClass *class = &search->classes[level[n]];
+        for (int i = 0; i < ALPHABET_SIZE; i++) {
+            remaining[i] -= class->sig.counts[i];
+        }
+        result = solvable(search, depth + 1, level, count, remaining,
+                remainingLen - class->length, level[n]);
+        for (int i = 0; i < ALPHABET_SIZE; i++) {
+            remaining[i] += class->sig.counts[i];
+        }
+    }
+    // The table may have grown while searching, so find the entry again.
+    entry = memo_entry(search, remaining, minClass);
+    entry->used = 1;
+    entry->solvable = result;
+    search->memoCount++;
+    return result;
+}
+
+/**
+ * Takes in the phrase search and writes the phrases held in its arena to
+ * the output, one per line, in the order they were found. The arena is
+ * then emptied for reuse, and the search marked as failed if the phrases
+ * could not be written. Returns 0 on success, and -1 on failure.
+ */
+static int flush_phrases(PhraseSearch *search) {
+    Dict *phrases = search->phrases;
+    uint32_t *order = (uint32_t *) malloc(sizeof(uint32_t) *
+            (phrases->wordCount + 1));
+    for (int p = 0; p < phrases->wordCount; p++) {
+        order[p] = p;
+    }
+    if (write_words(phrases, order, phrases->wordCount, '\n',
+            search->output) < 0) {
+        search->failed = 1;
+    }
+    free(order);
+    phrases->wordCount = 0;
+    phrases->poolSize = 0;
+    return search->failed ? -1 : 0;
+}
+
+/**
+ * Takes in the phrase search, the number of classes in the path, and the
+ * position in the path to choose a word for. Every choice of words for the
+ * classes of the path is added to the phrases, words separated by spaces.
+ * A class used more than once never repeats an earlier arrangement of its
+ * words. Nothing more is added once the phrases could not be written.
+ * Returns nothing.
+ */
+static void add_phrases(PhraseSearch *search, int pathLen, int position) {
+    if (position == pathLen) {
+        int length = 0;
+        for (int p = 0; p < pathLen; p++) {
+            const char *word = dict_word(search->dict, search->choice[p]);
+            int wordLen = search->classes[search->path[p]].length;
+            if (p) {
+                search->line[length++] = ' ';
+            }
+            memcpy(search->line + length, word, wordLen);
+            length += wordLen;
+        }
+        arena_add(search->phrases, search->line, length);
+        search->phraseCount++;
+        if (search->phrases->poolSize > PHRASE_FLUSH_SIZE) {
+            flush_phrases(search);
+        }
+        return;
+    }
+    const AnagramClass *class = &search->classes[search->path[position]];
+    int start = 0;
+    if (position && search->path[position] == search->path[position - 1]) {
+        // Continue from the word chosen for the same class just before.
+        while (search->members[class->first + start] !=
+                search->choice[position - 1]) {
+            start++;
+        }
+    }
+    for (int m = start; m < class->count && !search->failed; m++) {
+        search->choice[position] = search->members[class->first + m];
+        add_phrases(search, pathLen, position + 1);
+    }
+}
+
+/**
+ * The enumerate function takes in the phrase search, a depth, the
+ * candidate classes of the depth above, the letters remaining and their
+ * number, and the lowest class that may be used. Every way of using up
+ * the letters with classes in non-decreasing order is found, and its
+ * phrases are added. Only classes whose remainder is solvable are followed,
+ * so no branch is explored that does not lead to a phrase, and the search
+ * stops once the phrases could not be written. Returns nothing.
+ */
+static void enumerate(PhraseSearch *search, int depth, const int *parent,
+        int parentCount, uint8_t *remaining, int remainingLen, int minClass) {
+    if (remainingLen == 0) {
+        add_phrases(search, depth, 0);
+        return;
+    }
+    // Deeper searches only ever fill in the levels below this one.
+    int count = narrow(search, depth, parent, parentCount, remaining,
+            remainingLen, minClass);
+    const int *level = search->levels[depth];
+
+    for (int n = 0; n < count && !search->failed; n++) {
+        const AnagramClass *class = &search->classes[level[n]];
+        for (int i = 0; i < ALPHABET_SIZE; i++) {
+            remaining[i] -= class->sig.counts[i];
+        }
+        if (solvable(search, depth + 1, level, count, remaining,
+                remainingLen - class->length, level[n])) {
+            search->path[depth] = level[n];
+            enumerate(search, depth + 1, level, count, remaining,
+                    remainingLen - class->length, level[n]);
+        }
+        for (int i = 0; i < ALPHABET_SIZE; i++) {
+            remaining[i] += class->sig.counts[i];
+        }
+    }
+}
+
+/**
+ * The find_phrases function takes in a loaded dictionary, the letters
+ * argument and the output stream. It finds every multiset of dictionary
+ * words (of at least MIN_WORD_LEN letters) that uses up exactly the given
+ * letters, and writes each as a line of words separated by spaces, in
+ * batches as they are found. Words within a phrase follow the order of
+ * their anagram classes, and each class's words are in -alpha order.
+ * Returns the number of phrases written, or -1 if they could not be
+ * written.
+ */
+int find_phrases(Dict *dict, const char *letters, FILE *output) {
+    PhraseSearch search;
+    memset(&search, 0, sizeof(PhraseSearch));
+    search.dict = dict;
+    search.output = output;
+    int lettersLen = strlen(letters);
+
+    // Only the distinct words that fit in the letters can take part.
+    Query query;
+    prepare_query(&query, letters, NULL);
+    uint32_t *words = (uint32_t *) malloc(sizeof(uint32_t) *
+            (dict->wordCount ? dict->wordCount : 1));
+    int wordCount = filter_words(dict, &query, NULL, 1, words);
+    sort_alpha(dict, words, wordCount);
+    int distinct = 0;
+    for (int w = 0; w < wordCount; w++) {
+        if (!distinct || strcmp(dict_word(dict, words[w]),
+                dict_word(dict, words[distinct - 1])) != 0) {
+            words[distinct++] = words[w];
+        }
+    }
+    make_classes(&search, words, distinct);
+    make_reachable(&search, lettersLen);
+    free(words);
+
+    // A phrase has at most one word per MIN_WORD_LEN letters.
+    int maxDepth = lettersLen / MIN_WORD_LEN + 1;
+    search.levels = (int **) malloc(sizeof(int *) * (maxDepth + 1));
+    for (int d = 0; d <= maxDepth; d++) {
+        search.levels[d] = (int *) malloc(sizeof(int) *
+                (search.classCount + 1));
+    }
+    int *all = (int *) malloc(sizeof(int) * (search.classCount + 1));
+    for (int c = 0; c < search.classCount; c++) {
+        all[c] = c;
+    }
+    search.path = (int *) malloc(sizeof(int) * (maxDepth + 1));
+    search.choice = (uint32_t *) malloc(sizeof(uint32_t) * (maxDepth + 1));
+    search.line = (char *) malloc(lettersLen + maxDepth + NULL_T_SIZE);
+    search.phrases = new_arena();
+
+    uint8_t remaining[ALPHABET_SIZE];
+    memcpy(remaining, query.lettersSig.counts, ALPHABET_SIZE);
+    enumerate(&search, 0, all, search.classCount, remaining, lettersLen, 0);
+
+    if (!search.failed) {
+        flush_phrases(&search);
+    }
+
+    free_dict(search.phrases);
+    for (int d = 0; d <= maxDepth; d++) {
+        free(search.levels[d]);
+    }
+    free(search.levels);
+    free(all);
+    free(search.path);
+    free(search.choice);
+    free(search.line);
+    free(search.memo);
+    free(search.reachable);
+    free(search.members);
+    free(search.classes);
+    return search.failed ? -1 : search.phraseCount;
+}
+
+/**
+ * Handles "unjumble -phrase letters [dictionary]", which finds every set
+ * of dictionary words that together use exactly the given letters. It
+ * takes in the command line arguments and the argument structs, and exits
+ * with 0 if phrases were found, 10 if none were, 5 if they could not be
+ * written, and the command line's exit codes (1 to 4) for invalid
+ * arguments.
+ */
+void phrase_mode(int argc, char **argv, ArgType **argStructs) {
+    if (argc < MIN_PHRASE_ARGS || argc > MAX_PHRASE_ARGS) {
+        fprintf(stderr, PHRASE_USAGE);
+        free_structs(argStructs);
+        exit(1);
+    }
+    if (strlen(argv[2]) < 3) {
+        err_check(3, argStructs);
+    } else if (alpha_check(argv[2]) == -1) {
+        err_check(4, argStructs);
+    }
+    // Letters are counted in bytes, so no letter may be given too often.
+    Signature lettersSig;
+    make_signature(argv[2], strlen(argv[2]), &lettersSig);
+    if (lettersSig.mask & OVERFLOW_BIT) {
+        fprintf(stderr, PHRASE_USAGE);
+        free_structs(argStructs);
+        exit(1);
+    }
+
+    argStructs[3]->data = strdup(argc == MAX_PHRASE_ARGS ? argv[3] :
+            DEFAULT_DICT);
+    Dict *dict = load_dict(argStructs[3]->data);
+    if (!dict) {
+        err_check(2, argStructs);
+    }
+    int found = find_phrases(dict, argv[2], stdout);
+    free_dict(dict);
+    if (found < 0) {
+        fprintf(stderr, WRITE_MESSAGE);
+        free_structs(argStructs);
+        exit(5);
+    }
+    free_structs(argStructs);
+    exit(found ? 0 : 10);
+}
@@ -0,0 +1,57 @@
+#ifndef _PHRASE_H
+#define _PHRASE_H
+
+#include <stdint.h>
+#include "unjumble.h"
+#include "signature.h"
+
+// Macro Definitions
+#define MIN_PHRASE_ARGS 3
+#define MAX_PHRASE_ARGS 4
+#define INITIAL_MEMO 1024
+#define PHRASE_FLUSH_SIZE (1 << 20)
+#define PHRASE_USAGE "Usage: unjumble -phrase letters [dictionary]\n"
+
+// The distinct candidate words that are anagrams of each other.
+typedef struct {
+    Signature sig;          // Letter counts shared by every word
+    int length;             // Length of each word
+    int first;              // Position of the first word in the members
+    int count;              // Number of words in the class
+} AnagramClass;
+
+// An entry of the memo table, recording whether some letters can be used
+// up exactly by classes numbered minClass or above.
+typedef struct {
+    uint8_t counts[ALPHABET_SIZE];  // The letters left to use
+    uint8_t used;                   // True if the entry is filled in
+    uint8_t solvable;               // True if the letters can be used up
+    int minClass;                   // Lowest class that may be used
+} MemoEntry;
+
+// The state of a search for phrases.
+typedef struct {
+    Dict *dict;             // The dictionary the words come from
+    uint32_t *members;      // Candidate words grouped by class, alpha order
+    AnagramClass *classes;  // Classes in order of their first word
+    int classCount;
+    char *reachable;        // reachable[n] is true if n letters can be
+                            // made up of candidate word lengths
+    MemoEntry *memo;        // Open addressing table of searched states
+    size_t memoCap;
+    size_t memoCount;
+    int **levels;           // Candidate classes of each depth of the search
+    int *path;              // Classes of the phrase being built
+    uint32_t *choice;       // Word chosen from each class of the path
+    char *line;             // Text of the phrase being written
+    Dict *phrases;          // Arena of the phrases not yet written
+    int phraseCount;        // Number of phrases found
+    FILE *output;           // Where the phrases are written
+    int failed;             // True once the phrases could not be written
+} PhraseSearch;
+
+// Function Declarations
+int find_phrases(Dict *dict, const char *letters, FILE *output);
+void phrase_mode(int argc, char **argv, ArgType **argStructs);
+
+#endif
@@ -0,0 +1,372 @@
+/**
+ * Author: Ethan Pinto
+ * Student Number: s4642286
+ * Program Name: unjumble
+ * File Name: serve.c
+**/
+
+#include "serve.h"
+#include "cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libgen.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/inotify.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/**
+ * Takes in a loaded dictionary and returns a new snapshot of it, which
+ * keeps the results of recent queries. Returns the snapshot.
+ */
+Snapshot *new_snapshot(Dict *dict) {
+    Snapshot *snapshot = (Snapshot *) malloc(sizeof(Snapshot));
+    snapshot->dict = dict;
+    snapshot->users = 0;
+    dict->cache = new_cache();
+    return snapshot;
+}
+
+/**
+ * Takes in the served dictionary and returns its current snapshot, which
+ * stays valid until it is given back with release_snapshot.
+ */
+Snapshot *acquire_snapshot(LiveDict *live) {
+    pthread_mutex_lock(&live->lock);
+    Snapshot *snapshot = live->current;
+    snapshot->users++;
+    pthread_mutex_unlock(&live->lock);
+    return snapshot;
+}
+
+/**
+ * Takes in the served dictionary and a snapshot taken by acquire_snapshot.
+ * The snapshot is freed if it has been replaced and this was the last
+ * query using it. Returns nothing.
+ */
+void release_snapshot(LiveDict *live, Snapshot *snapshot) {
+    pthread_mutex_lock(&live->lock);
+    int unused = --snapshot->users == 0 && snapshot != live->current;
+    pthread_mutex_unlock(&live->lock);
+    if (unused) {
+        free_dict(snapshot->dict);
+        free(snapshot);
+    }
+}
+
+/**
+ * The swap_snapshot function takes in the served dictionary and a newly
+ * loaded version of it, and makes the new version the one later queries
+ * use. Queries already running keep the old version, which is freed by
+ * the last of them to finish, or here if none are running.
+ * Returns nothing.
+ */
+void swap_snapshot(LiveDict *live, Dict *dict) {
+    Snapshot *snapshot = new_snapshot(dict);
+    pthread_mutex_lock(&live->lock);
+    Snapshot *old = live->current;
+    live->current = snapshot;
+    int unused = old->users == 0;
+    pthread_mutex_unlock(&live->lock);
+    if (unused) {
+        free_dict(old->dict);
+        free(old);
+    }
+}
+
+/**
+ * Takes in the served dictionary and a newly loaded version of it, and
+ * checks the new version can replace the one being served: it must hold
+ * words, and be the same kind of dictionary (text or compiled index), so
+ * a file emptied or cut short by a writer is never served. Only the
+ * watcher changes the current snapshot, so it is read here unlocked.
+ * Returns 1 if the new version can be served, and 0 otherwise.
+ */
+static int reload_ok(LiveDict *live, const Dict *dict) {
+    return dict->wordCount > 0 &&
+            dict->indexed == live->current->dict->indexed;
+}
+
+/**
+ * Takes in an inotify descriptor, the path of a file and the watched file
+ * to fill in, and adds a watch on the directory holding the file, since a
+ * file replaced by renaming a new one over it can no longer be watched
+ * itself. Returns the watch descriptor, or -1 if it could not be added.
+ */
+static int watch_file(int watchFd, const char *path, WatchedFile *file) {
+    char *dirCopy = strdup(path);
+    file->path = strdup(path);
+    file->nameCopy = strdup(path);
+    file->name = basename(file->nameCopy);
+    file->watch = inotify_add_watch(watchFd, dirname(dirCopy), WATCH_EVENTS);
+    free(dirCopy);
+    return file->watch;
+}
+
+/**
+ * Takes in an inotify descriptor, a watched file and another watched file
+ * whose watch must be kept, and removes the first file's watch unless the
+ * other shares it. Returns nothing.
+ */
+static void unwatch_file(int watchFd, WatchedFile *file,
+        const WatchedFile *keep) {
+    if (file->watch >= 0 && file->watch != keep->watch) {
+        inotify_rm_watch(watchFd, file->watch);
+    }
+    free(file->path);
+    free(file->nameCopy);
+}
+
+/**
+ * Takes in a watched file and an inotify event. Returns 1 if the event is
+ * about the file, and 0 otherwise.
+ */
+static int watched_event(const WatchedFile *file,
+        const struct inotify_event *event) {
+    return file->watch >= 0 && event->wd == file->watch && event->len &&
+            strcmp(event->name, file->name) == 0;
+}
+
+/**
+ * Takes in an inotify descriptor, the name of the served dictionary, the
+ * watched file it resolves to and the watched name itself. If the name now
+ * resolves (through symbolic links) to a different file, that file is
+ * watched in place of the old one. Returns nothing.
+ */
+static void follow_target(int watchFd, const char *dictName,
+        WatchedFile *target, const WatchedFile *link) {
+    char *resolved = realpath(dictName, NULL);
+    if (resolved && strcmp(resolved, target->path) != 0) {
+        WatchedFile old = *target;
+        watch_file(watchFd, resolved, target);
+        // The old directory may still be watched for the new file.
+        unwatch_file(watchFd, &old, old.watch == target->watch ? target :
+                link);
+    }
+    free(resolved);
+}
+
+/**
+ * The watch_dict thread function takes in a pointer to the served
+ * dictionary. It watches the directory holding the dictionary's name and,
+ * if that name is a symbolic link, the directory holding the file it
+ * resolves to, so edits to either are seen (the default dictionary is
+ * often such a link). Whenever the file is rewritten or replaced,
+ * the new version is copied into memory in this thread while queries go
+ * on using the old one, and then swapped in. A version that cannot be
+ * read in full, fails validation, or is rejected by reload_ok is skipped,
+ * and the old one kept.
+ * Returns NULL if the directory cannot be watched.
+ */
+void *watch_dict(void *arg) {
+    LiveDict *live = (LiveDict *)arg;
+    WatchedFile link;
+    WatchedFile target;
+    int watchFd = inotify_init1(IN_CLOEXEC);
+    if (watchFd < 0 || watch_file(watchFd, live->dictName, &link) < 0) {
+        fprintf(stderr, "unjumble: dictionary \"%s\" will not be reloaded\n",
+                live->dictName);
+        if (watchFd >= 0) {
+            unwatch_file(watchFd, &link, &link);
+            close(watchFd);
+        }
+        return NULL;
+    }
+    // Until the name is resolved, the target is the name itself.
+    watch_file(watchFd, live->dictName, &target);
+    follow_target(watchFd, live->dictName, &target, &link);
+
+    char buffer[WATCH_BUFFER_SIZE]
+            __attribute__((aligned(__alignof__(struct inotify_event))));
+    ssize_t got;
+    while ((got = read(watchFd, buffer, sizeof(buffer))) > 0) {
+        // Reload once for every event read together.
+        int changed = 0;
+        for (char *next = buffer; next < buffer + got;
+                next += sizeof(struct inotify_event) +
+                ((struct inotify_event *)next)->len) {
+            struct inotify_event *event = (struct inotify_event *)next;
+            changed |= watched_event(&link, event) ||
+                    watched_event(&target, event);
+        }
+        if (changed) {
+            // The link may have been pointed at another file.
+            follow_target(watchFd, live->dictName, &target, &link);
+        }
+        Dict *dict = changed ? copy_dict(live->dictName) : NULL;
+        if (dict && reload_ok(live, dict)) {
+            swap_snapshot(live, dict);
+        } else if (changed) {
+            free_dict(dict);
+            fprintf(stderr, "unjumble: dictionary \"%s\" can not be "
+                    "reloaded\n", live->dictName);
+        }
+    }
+    unwatch_file(watchFd, &target, &link);
+    unwatch_file(watchFd, &link, &link);
+    close(watchFd);
+    return NULL;
+}
+
+/**
+ * The answer_request function takes in a line sent by a client, the
+ * served dictionary and the stream used to reply to the client. It runs
+ * the query against the current version of the dictionary and writes the
+ * same output the command line would print, followed by an empty line
+ * marking the end of the response. Invalid queries are answered with the
+ * command line's error message instead. Returns nothing.
+ */
+void answer_request(char *line, LiveDict *live, FILE *reply) {
+    ArgType **argStructs = create_structs();
+
+    int status = parse_request(line, argStructs);
+    if (status) {
+        write_request_error(status, reply);
+    } else {
+        Snapshot *snapshot = acquire_snapshot(live);
+        run_query(argStructs, snapshot->dict, reply, NULL);
+        release_snapshot(live, snapshot);
+    }
+    fprintf(reply, "\n");
+    fflush(reply);
+    free_structs(argStructs);
+}
+
+/**
+ * The handle_client thread function takes in a pointer to a ClientInfo
+ * struct. It reads queries from the client one line at a time and answers
+ * each of them, until the client disconnects. It returns NULL.
+ */
+void *handle_client(void *info) {
+    ClientInfo *client = (ClientInfo *)info;
+    FILE *request = fdopen(client->clientFd, "r");
+    FILE *reply = fdopen(dup(client->clientFd), "w");
+    char *line = NULL;
+    size_t lineSize = 0;
+
+    if (request && reply) {
+        while (getline(&line, &lineSize, request) >= 0) {
+            answer_request(line, client->live, reply);
+        }
+    }
+    free(line);
+    if (reply) {
+        fclose(reply);
+    }
+    if (request) {
+        fclose(request);
+    } else {
+        close(client->clientFd);
+    }
+    free(client);
+    return NULL;
+}
+
+/**
+ * The open_socket function takes in the path of a Unix domain socket.
+ * Any stale socket file at that path is removed, and a new socket is bound
+ * to it and set to listen for connections.
+ * Returns the listening file descriptor, or -1 if it could not be opened.
+ */
+int open_socket(const char *path) {
+    struct sockaddr_un address;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        return -1;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+
+    int serverFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (serverFd < 0) {
+        return -1;
+    }
+    unlink(path);
+    if (bind(serverFd, (struct sockaddr *)&address, sizeof(address)) ||
+            listen(serverFd, CONNECTION_LIMIT)) {
+        close(serverFd);
+        return -1;
+    }
+    return serverFd;
+}
+
+/**
+ * The process_connections function takes in the listening socket and the
+ * served dictionary. It repeatedly accepts clients and spawns a detached
+ * thread to handle each one. It never returns.
+ */
+void process_connections(int serverFd, LiveDict *live) {
+    while (1) {
+        int clientFd = accept(serverFd, NULL, NULL);
+        if (clientFd < 0) {
+            continue;
+        }
+        ClientInfo *client = (ClientInfo *) malloc(sizeof(ClientInfo));
+        client->clientFd = clientFd;
+        client->live = live;
+
+        // Create a new thread to handle the client's queries.
+        pthread_t threadId;
+        if (pthread_create(&threadId, NULL, handle_client, client)) {
+            close(clientFd);
+            free(client);
+            continue;
+        }
+        pthread_detach(threadId);
+    }
+}
+
+/**
+ * Handles "unjumble -serve socket [dictionary]". The dictionary is loaded
+ * once and then queries from any number of clients are answered over the
+ * Unix domain socket. The results of recent queries are kept, so clients
+ * asking for the same letters again are answered without a search, and
+ * the dictionary is reloaded in the background whenever its file changes.
+ * The dictionary is copied into memory rather than mapped, so no change
+ * to the file can disturb a running query. It should be updated by
+ * renaming a complete new file over it, as -compile does; a file
+ * rewritten in place is reloaded when it is closed, and a version that is
+ * empty or invalid is ignored.
+ * It takes in the command line arguments and the argument structs, and exits
+ * with 1 on a usage error, 2 if the dictionary cannot be opened (or is a
+ * DAWG, which can only be searched from the command line) and 6 if the
+ * socket cannot be opened.
+ */
+void serve_mode(int argc, char **argv, ArgType **argStructs) {
+    if (argc < MIN_SERVE_ARGS || argc > MAX_SERVE_ARGS) {
+        fprintf(stderr, SERVE_USAGE);
+        free_structs(argStructs);
+        exit(1);
+    }
+    argStructs[3]->data = strdup(argc == MAX_SERVE_ARGS ? argv[3] :
+            DEFAULT_DICT);
+
+    Dict *dict = copy_dict(argStructs[3]->data);
+    if (!dict) {
+        err_check(2, argStructs);
+    }
+    int serverFd = open_socket(argv[2]);
+    if (serverFd < 0) {
+        fprintf(stderr, "unjumble: unable to listen on \"%s\"\n", argv[2]);
+        free_dict(dict);
+        free_structs(argStructs);
+        exit(6);
+    }
+
+    LiveDict live;
+    pthread_mutex_init(&live.lock, NULL);
+    live.current = new_snapshot(dict);
+    live.dictName = argStructs[3]->data;
+    pthread_t watcherId;
+    if (pthread_create(&watcherId, NULL, watch_dict, &live) == 0) {
+        pthread_detach(watcherId);
+    }
+
+    // A client disconnecting mid-reply must not stop the server.
+    signal(SIGPIPE, SIG_IGN);
+    process_connections(serverFd, &live);
+}
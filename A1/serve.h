@@ -0,0 +1,48 @@
+#ifndef _SERVE_H
+#define _SERVE_H
+
+#include <pthread.h>
+#include "unjumble.h"
+
+// Macro Definitions
+#define CONNECTION_LIMIT 64
+#define MIN_SERVE_ARGS 3
+#define MAX_SERVE_ARGS 4
+#define SERVE_USAGE "Usage: unjumble -serve socket [dictionary]\n"
+#define WATCH_BUFFER_SIZE 4096
+#define WATCH_EVENTS (IN_CLOSE_WRITE | IN_MOVED_TO)
+
+// One loaded version of the dictionary being served. Once a newer version
+// replaces it, it is freed when the last query using it finishes.
+typedef struct {
+    Dict *dict;         // The loaded dictionary and its cached results
+    int users;          // Number of queries using this version
+} Snapshot;
+
+// The dictionary being served, which is reloaded whenever its file
+// changes. Queries take the current snapshot when they start, so a reload
+// never changes the words a running query sees.
+typedef struct {
+    pthread_mutex_t lock;   // Held while the current snapshot is changed
+    Snapshot *current;      // The newest loaded version
+    char *dictName;         // Name of the dictionary file
+} LiveDict;
+
+// A file whose changes are seen through an inotify watch on its directory.
+typedef struct {
+    int watch;          // Watch descriptor of the directory, or -1
+    char *path;         // The file's path
+    char *nameCopy;     // Copy of the path that name points into
+    char *name;         // The file's name within the directory
+} WatchedFile;
+
+// Contains the information a client handling thread needs.
+typedef struct {
+    int clientFd;       // Connected client socket
+    LiveDict *live;     // Dictionary shared by every client
+} ClientInfo;
+
+// Function Declarations
+void serve_mode(int argc, char **argv, ArgType **argStructs);
+
+#endif
@@ -0,0 +1,88 @@
+/**
+ * Author: Ethan Pinto
+ * Student Number: s4642286
+ * Program Name: unjumble
+ * File Name: signature.c
+**/
+
+#include "signature.h"
+#include <ctype.h>
+#include <string.h>
+
+/**
+ * Takes in a character and returns its position in the alphabet (0 to 25)
+ * ignoring case, or -1 if the character is not a letter.
+ */
+int letter_index(char letter) {
+    if (letter >= 'a' && letter <= 'z') {
+        return letter - 'a';
+    } else if (letter >= 'A' && letter <= 'Z') {
+        return letter - 'A';
+    }
+    return -1;
+}
+
+/**
+ * The make_signature function takes in a word, its length, and a pointer
+ * to the signature to fill in. It counts each letter of the word ignoring
+ * case and records which letters are present. Words containing characters
+ * that are not letters are flagged with NON_ALPHA_BIT, and words with more
+ * than MAX_LETTER_COUNT of one letter are flagged with OVERFLOW_BIT.
+ * Returns nothing.
+ */
+void make_signature(const char *word, int length, Signature *sig) {
+    memset(sig, 0, sizeof(Signature));
+
+    for (int i = 0; i < length; i++) {
+        int index = letter_index(word[i]);
+        if (index < 0) {
+            sig->mask |= NON_ALPHA_BIT;
+        } else if (sig->counts[index] == MAX_LETTER_COUNT) {
+            sig->mask |= OVERFLOW_BIT;
+        } else {
+            sig->counts[index]++;
+            sig->mask |= 1u << index;
+        }
+    }
+}
+
+/**
+ * Takes in a word and the letters argument and checks exactly whether the
+ * word can be made from the letters, using a blank tile for any letter
+ * that runs out. It is only needed when a signature count has overflowed.
+ * Returns 1 if the word can be made and -1 otherwise.
+ */
+int exact_fit(const char *word, const char *letters) {
+    int available[ALPHABET_SIZE] = {0};
+    int blanks = 0;
+
+    for (int i = 0; letters[i]; i++) {
+        int index = letter_index(letters[i]);
+        if (index >= 0) {
+            available[index]++;
+        } else if (letters[i] == BLANK_TILE) {
+            blanks++;
+        }
+    }
+    for (int j = 0; word[j]; j++) {
+        int index = letter_index(word[j]);
+        if (index < 0 || (--available[index] < 0 && --blanks < 0)) {
+            return -1;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Checks if the letters argument is composed only of letters and blank
+ * tiles, each of which can stand in for any letter.
+ * Returns 1 if it is, and -1 otherwise.
+ */
+int letters_check(const char *letters) {
+    for (int i = 0; letters[i]; i++) {
+        if (!isalpha(letters[i]) && letters[i] != BLANK_TILE) {
+            return -1;
+        }
+    }
+    return 1;
+}
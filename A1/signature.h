@@ -0,0 +1,36 @@
+#ifndef _SIGNATURE_H
+#define _SIGNATURE_H
+
+#include <stdint.h>
+
+// Macro Definitions
+#define ALPHABET_SIZE 26
+#define MAX_LETTER_COUNT 255
+#define BLANK_TILE '?'
+#define NON_ALPHA_BIT (1u << ALPHABET_SIZE)
+#define OVERFLOW_BIT (1u << (ALPHABET_SIZE + 1))
+#define LETTER_BITS ((1u << ALPHABET_SIZE) - 1)
+
+// The case-folded letter histogram of a word, computed once so that
+// matching a word against the letters argument takes constant time.
+typedef struct {
+    uint32_t mask;                   // Bit i is set if letter i is present
+    uint8_t counts[ALPHABET_SIZE];   // Occurrences of each letter
+    uint8_t pad[2];                  // Keeps the struct 32 bytes wide
+} Signature;
+
+// Function Declarations
+void make_signature(const char *word, int length, Signature *sig);
+int letter_index(char letter);
+int exact_fit(const char *word, const char *letters);
+int letters_check(const char *letters);
+
+/**
+ * Takes in the presence bit of a single letter and the letter mask of a
+ * word. Returns 1 if the word contains the letter, and -1 otherwise.
+ */
+static inline int has_single_letter(uint32_t letterBit, uint32_t wordMask) {
+    return (wordMask & letterBit) ? 1 : -1;
+}
+
+#endif
@@ -0,0 +1,352 @@
+/**
+ * Author: Ethan Pinto
+ * Student Number: s4642286
+ * Program Name: unjumble
+ * File Name: sort.c
+**/
+
+#define _GNU_SOURCE
+#include "sort.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Takes in a byte and returns it case folded the way strcasecmp folds it in
+ * the C locale.
+ */
+static inline unsigned char fold(unsigned char byte) {
+    return (byte >= 'A' && byte <= 'Z') ? byte - 'A' + 'a' : byte;
+}
+
+/**
+ * Takes in a sort key and a depth, and returns the key's byte at that
+ * depth, case folded if folded is set. The terminator, and so every word's
+ * end, is byte 0.
+ */
+static inline unsigned char key_byte(const SortKey *key, int depth,
+        int folded) {
+    if (!folded) {
+        return key->word[depth];
+    }
+    if (depth < KEY_PREFIX_LEN) {
+        return (key->prefix >> (8 * (KEY_PREFIX_LEN - 1 - depth))) & 0xff;
+    }
+    return fold(key->word[depth]);
+}
+
+/**
+ * The comparison function for sort keys. It orders them exactly as
+ * cmp_alpha orders words: by case folded bytes, then by the original bytes.
+ */
+static int cmp_key(const void *key1, const void *key2) {
+    const SortKey *first = (const SortKey *)key1;
+    const SortKey *second = (const SortKey *)key2;
+    if (first->prefix != second->prefix) {
+        return first->prefix < second->prefix ? -1 : 1;
+    }
+    // Equal prefixes either end together or continue past the prefix.
+    if (first->prefix & 0xff) {
+        for (int depth = KEY_PREFIX_LEN; ; depth++) {
+            unsigned char byte1 = fold(first->word[depth]);
+            unsigned char byte2 = fold(second->word[depth]);
+            if (byte1 != byte2) {
+                return byte1 < byte2 ? -1 : 1;
+            }
+            if (!byte1) {
+                break;
+            }
+        }
+    }
+    int result = strcmp((const char *)first->word,
+            (const char *)second->word);
+    return (result > 0) - (result < 0);
+}
+
+/**
+ * Takes in a small range of sort keys and sorts it with insertion sort.
+ * Returns nothing.
+ */
+static void insertion_sort(SortKey *keys, int count) {
+    for (int i = 1; i < count; i++) {
+        SortKey key = keys[i];
+        int j = i;
+        while (j > 0 && cmp_key(&keys[j - 1], &key) > 0) {
+            keys[j] = keys[j - 1];
+            j--;
+        }
+        keys[j] = key;
+    }
+}
+
+/**
+ * The radix_sort function takes in a range of sort keys whose first depth
+ * bytes are equal, a scratch buffer at least as large, and whether the
+ * bytes compared are case folded. It sorts the range by the byte at depth
+ * and recurses into each bucket. Keys that are equal when folded are then
+ * sorted again by their original bytes, giving the cmp_alpha order.
+ * Returns nothing.
+ */
+static void radix_sort(SortKey *keys, SortKey *scratch, int count, int depth,
+        int folded) {
+    if (count < INSERTION_LIMIT || depth > MAX_RADIX_DEPTH) {
+        // Small or deeply shared ranges are cheaper to compare directly.
+        if (count < INSERTION_LIMIT) {
+            insertion_sort(keys, count);
+        } else {
+            qsort(keys, count, sizeof(SortKey), cmp_key);
+        }
+        return;
+    }
+
+    int counts[RADIX_BUCKETS] = {0};
+    for (int i = 0; i < count; i++) {
+        counts[key_byte(&keys[i], depth, folded)]++;
+    }
+    int starts[RADIX_BUCKETS];
+    int position = 0;
+    for (int bucket = 0; bucket < RADIX_BUCKETS; bucket++) {
+        starts[bucket] = position;
+        position += counts[bucket];
+    }
+    for (int i = 0; i < count; i++) {
+        scratch[starts[key_byte(&keys[i], depth, folded)]++] = keys[i];
+    }
+    memcpy(keys, scratch, sizeof(SortKey) * count);
+
+    // Bucket 0 holds the words that end here.
+    if (folded && counts[0] > 1) {
+        radix_sort(keys, scratch, counts[0], 0, 0);
+    }
+    position = counts[0];
+    for (int bucket = 1; bucket < RADIX_BUCKETS; bucket++) {
+        if (counts[bucket] > 1) {
+            radix_sort(keys + position, scratch, counts[bucket], depth + 1,
+                    folded);
+        }
+        position += counts[bucket];
+    }
+}
+
+/**
+ * Takes in the dictionary and an array of word indices, and returns a newly
+ * allocated array of their sort keys, or NULL if memory could not be
+ * allocated.
+ */
+static SortKey *make_keys(const Dict *dict, const uint32_t *words,
+        int wordCount) {
+    SortKey *keys = (SortKey *) malloc(sizeof(SortKey) *
+            (wordCount ? wordCount : 1));
+    if (!keys) {
+        return NULL;
+    }
+    for (int i = 0; i < wordCount; i++) {
+        const unsigned char *word =
+                (const unsigned char *)dict_word(dict, words[i]);
+        uint64_t prefix = 0;
+        int depth = 0;
+        for (; depth < KEY_PREFIX_LEN && word[depth]; depth++) {
+            prefix = (prefix << 8) | fold(word[depth]);
+        }
+        keys[i].prefix = prefix << (8 * (KEY_PREFIX_LEN - depth));
+        keys[i].word = word;
+        keys[i].length = dict->lengths[words[i]];
+        keys[i].index = words[i];
+    }
+    return keys;
+}
+
+/**
+ * Takes in the dictionary and an array of word indices, and sorts the
+ * indices into -alpha order. The order is identical to sorting with
+ * cmp_alpha. Returns nothing.
+ */
+void sort_alpha(const Dict *dict, uint32_t *words, int wordCount) {
+    SortKey *keys = make_keys(dict, words, wordCount);
+    SortKey *scratch = (SortKey *) malloc(sizeof(SortKey) *
+            (wordCount ? wordCount : 1));
+    if (!keys || !scratch) {
+        free(keys);
+        free(scratch);
+        qsort_r(words, wordCount, sizeof(uint32_t), cmp_alpha, (void *)dict);
+        return;
+    }
+    radix_sort(keys, scratch, wordCount, 0, 1);
+    for (int i = 0; i < wordCount; i++) {
+        words[i] = keys[i].index;
+    }
+    free(keys);
+    free(scratch);
+}
+
+/**
+ * Takes in the dictionary and an array of word indices, and sorts the
+ * indices into -len order. The keys are first bucketed by length, longest
+ * first, with a stable radix sort, then each length is sorted into -alpha
+ * order. The order is identical to sorting with cmp_len. Returns nothing.
+ */
+void sort_len(const Dict *dict, uint32_t *words, int wordCount) {
+    SortKey *keys = make_keys(dict, words, wordCount);
+    SortKey *scratch = (SortKey *) malloc(sizeof(SortKey) *
+            (wordCount ? wordCount : 1));
+    if (!keys || !scratch) {
+        free(keys);
+        free(scratch);
+        qsort_r(words, wordCount, sizeof(uint32_t), cmp_len, (void *)dict);
+        return;
+    }
+
+    // Sort by length a byte at a time, skipping bytes every length shares.
+    for (int shift = 0; shift < 32; shift += 8) {
+        int counts[RADIX_BUCKETS] = {0};
+        for (int i = 0; i < wordCount; i++) {
+            counts[0xff - ((keys[i].length >> shift) & 0xff)]++;
+        }
+        if (wordCount == 0 || counts[0xff - ((keys[0].length >> shift) &
+                0xff)] == wordCount) {
+            continue;
+        }
+        int position = 0;
+        for (int bucket = 0; bucket < RADIX_BUCKETS; bucket++) {
+            int bucketCount = counts[bucket];
+            counts[bucket] = position;
+            position += bucketCount;
+        }
+        for (int i = 0; i < wordCount; i++) {
+            scratch[counts[0xff - ((keys[i].length >> shift) & 0xff)]++] =
+                    keys[i];
+        }
+        memcpy(keys, scratch, sizeof(SortKey) * wordCount);
+    }
+
+    // Sort each run of equal length words alphabetically.
+    for (int start = 0; start < wordCount; ) {
+        int end = start + 1;
+        while (end < wordCount && keys[end].length == keys[start].length) {
+            end++;
+        }
+        radix_sort(keys + start, scratch, end - start, 0, 1);
+        start = end;
+    }
+    for (int i = 0; i < wordCount; i++) {
+        words[i] = keys[i].index;
+    }
+    free(keys);
+    free(scratch);
+}
+
+/**
+ * The comparison function for the "-alpha" argument. It is used to sort
+ * an array of word indices into the given dictionary in lexicographical
+ * order.
+ * Returns 1 if word1 should go after word2.
+ * Returns -1 if word1 should go before word2
+ * Returns 0 if the words are the same alphabetically.
+ */
+int cmp_alpha(const void *index1, const void *index2, void *dict) {
+    const char *word1 = dict_word(dict, *(const uint32_t *)index1);
+    const char *word2 = dict_word(dict, *(const uint32_t *)index2);
+    int result = strcasecmp(word1, word2);
+    // Check the return value of strcasecmp function.
+    if (result == 0) {
+        int compareValue = strcmp(word1, word2);
+        if (compareValue > 0) {
+            return 1;
+        } else if (compareValue < 0) {
+            return -1;
+        } else {
+            return 0;
+        }
+    } 
+    return result;
+}
+
+/**
+ * The comparison function for the "-len" argument. It is used to sort
+ * an array of word indices into the given dictionary in descending length,
+ * using the stored word lengths.
+ * Returns 1 if word1 is shorter than word2.
+ * Returns -1 if word1 is longest than word2.
+ * Returns result of cmp_alpha if the words are the same length.
+ */ 
+int cmp_len(const void *index1, const void *index2, void *dict) {
+    int length1 = ((Dict *)dict)->lengths[*(const uint32_t *)index1];
+    int length2 = ((Dict *)dict)->lengths[*(const uint32_t *)index2];
+
+    // Compare the length of each word.
+    if (length1 > length2) {
+        return -1; // word 1 is longer than word 2.
+    } else if (length1 < length2) {
+        return 1; // word 1 is shorter than word 2.
+    } 
+    return cmp_alpha(index1, index2, dict);
+}
+
+/**
+ * Takes in a dictionary, a comparison function and an array of word
+ * indices and its length. Words from a dictionary file that is already
+ * sorted match in sorted order, so checking for that first, which stops at
+ * the first pair out of order, saves sorting them again.
+ * Returns 1 if the words are already in the comparison's order, and 0
+ * otherwise.
+ */
+static int in_order(Dict *dict, int (*cmp)(const void *, const void *,
+        void *), const uint32_t *words, int wordCount) {
+    for (int i = 1; i < wordCount; i++) {
+        if (cmp(&words[i - 1], &words[i], dict) > 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Finds the largest word/s in the dictionary in a single pass and removes
+ * any words that are shorter than this word length, then sorts the words
+ * that are left alphabetically. The sort is skipped if the words are
+ * already presorted by length, or are already in alphabetical order.
+ * Returns the number of words kept.
+ */ 
+int cmp_longest(Dict *dict, uint32_t *sortedWords, int wordCount,
+        int presorted) {
+    int maxLength = 0;
+    for (int i = 0; i < wordCount; i++) {
+        if (dict->lengths[sortedWords[i]] > maxLength) {
+            maxLength = dict->lengths[sortedWords[i]];
+        }
+    }
+    // Keep just the longest words, in the order they were given.
+    int kept = 0;
+    for (int i = 0; i < wordCount; i++) {
+        if (dict->lengths[sortedWords[i]] == maxLength) {
+            sortedWords[kept++] = sortedWords[i];
+        }
+    }
+    if (!presorted && !in_order(dict, cmp_alpha, sortedWords, kept)) {
+        sort_alpha(dict, sortedWords, kept);
+    }
+    return kept;
+}
+
+/**
+ * The order_words function takes in the dictionary, the order to put the
+ * words in (one of the ORDER macros), an array of matching word indices
+ * and its length, and whether the words are known to be in that order.
+ * The words are sorted unless they turn out to be in order already, and
+ * for ORDER_LONGEST all but the longest are dropped.
+ * Returns the number of words kept.
+ */
+int order_words(Dict *dict, int order, uint32_t *words, int wordCount,
+        int presorted) {
+    if (order == ORDER_ALPHA && !presorted &&
+            !in_order(dict, cmp_alpha, words, wordCount)) {
+        sort_alpha(dict, words, wordCount);
+
+    } else if (order == ORDER_LEN && !presorted &&
+            !in_order(dict, cmp_len, words, wordCount)) {
+        sort_len(dict, words, wordCount);
+
+    } else if (order == ORDER_LONGEST) {
+        wordCount = cmp_longest(dict, words, wordCount, presorted);
+    }
+    return wordCount;
+}
@@ -0,0 +1,37 @@
+#ifndef _SORT_H
+#define _SORT_H
+
+#include <stdint.h>
+#include "dict.h"
+
+// Macro Definitions
+#define KEY_PREFIX_LEN 8
+#define RADIX_BUCKETS 256
+#define INSERTION_LIMIT 32
+#define MAX_RADIX_DEPTH 64
+#define ORDER_NONE 0
+#define ORDER_ALPHA 1
+#define ORDER_LEN 2
+#define ORDER_LONGEST 3
+
+// The sort key of a word, built once before sorting. The first
+// KEY_PREFIX_LEN case folded bytes are packed into prefix, most significant
+// first, so the top levels of the sort never touch the word text.
+typedef struct {
+    uint64_t prefix;            // Leading case folded bytes, zero padded
+    const unsigned char *word;  // The word's text, null terminated
+    uint32_t length;            // Length of the word
+    uint32_t index;             // Index of the word in the dictionary
+} SortKey;
+
+// Function Declarations
+void sort_alpha(const Dict *dict, uint32_t *words, int wordCount);
+void sort_len(const Dict *dict, uint32_t *words, int wordCount);
+int cmp_alpha(const void *index1, const void *index2, void *dict);
+int cmp_len(const void *index1, const void *index2, void *dict);
+int cmp_longest(Dict *dict, uint32_t *sortedWords, int wordCount,
+        int presorted);
+int order_words(Dict *dict, int order, uint32_t *words, int wordCount,
+        int presorted);
+
+#endif
@@ -0,0 +1,45 @@
+/**
+ * Author: Ethan Pinto
+ * Student Number: s4642286
+ * Program Name: unjumble
+ * File Name: stats.c
+**/
+
+#include "stats.h"
+#include <time.h>
+#include <sys/resource.h>
+
+/**
+ * Returns the time in seconds on a clock that only moves forwards, for
+ * measuring how long a part of a query takes.
+ */
+double stats_clock(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/**
+ * The write_stats function takes in the statistics of a query and the
+ * stream to write them to, and writes one "name: value" line for each,
+ * followed by the peak resident set size of the process.
+ * Returns nothing.
+ */
+void write_stats(const QueryStats *stats, FILE *output) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    fprintf(output, "load time: %.6f s\n", stats->load);
+    fprintf(output, "filter time: %.6f s\n", stats->filter);
+    fprintf(output, "sort time: %.6f s\n", stats->sort);
+    fprintf(output, "output time: %.6f s\n", stats->output);
+    fprintf(output, "words scanned: %ld\n", stats->scanned);
+    fprintf(output, "rejected by length: %ld\n",
+            stats->rejected[REJECT_LENGTH]);
+    fprintf(output, "rejected by include: %ld\n",
+            stats->rejected[REJECT_INCLUDE]);
+    fprintf(output, "rejected by letters: %ld\n",
+            stats->rejected[REJECT_LETTERS]);
+    fprintf(output, "words matched: %ld\n", stats->matched);
+    fprintf(output, "words written: %ld\n", stats->written);
+    fprintf(output, "peak RSS: %ld KB\n", usage.ru_maxrss);
+}
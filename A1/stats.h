@@ -0,0 +1,30 @@
+#ifndef _STATS_H
+#define _STATS_H
+
+#include <stdio.h>
+
+// Macro Definitions
+#define REJECT_LENGTH 0
+#define REJECT_INCLUDE 1
+#define REJECT_LETTERS 2
+#define REJECT_KINDS 3
+
+// Where the time of a -stats query went, and what became of the words it
+// looked at. Each word is counted against the first check it failed, in
+// the order length, -include letter, then letters.
+typedef struct {
+    double load;                    // Seconds loading the dictionary
+    double filter;                  // Seconds finding the matches
+    double sort;                    // Seconds sorting the matches
+    double output;                  // Seconds writing the matches
+    long scanned;                   // Words looked at
+    long rejected[REJECT_KINDS];    // Words rejected by each check
+    long matched;                   // Words that passed every check
+    long written;                   // Words written
+} QueryStats;
+
+// Function Declarations
+double stats_clock(void);
+void write_stats(const QueryStats *stats, FILE *output);
+
+#endif
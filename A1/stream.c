@@ -0,0 +1,189 @@
+/**
+ * Author: Ethan Pinto
+ * Student Number: s4642286
+ * Program Name: unjumble
+ * File Name: stream.c
+**/
+
+#define _GNU_SOURCE
+#include "stream.h"
+#include "index.h"
+#include "merge.h"
+#include "sort.h"
+#include <ctype.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/**
+ * Takes in the argument following "-mem", a whole number of bytes that
+ * may end in K, M or G for kibibytes, mebibytes or gibibytes.
+ * Returns the number of bytes, or -1 if it is not valid or is less than
+ * MIN_MEM.
+ */
+long mem_check(const char *memArg) {
+    char *end;
+    long budget = strtol(memArg, &end, 10);
+    if (!isdigit(memArg[0]) || budget < 0) {
+        return -1;
+    }
+    const char *units = "KMG";
+    const char *unit = *end ? strchr(units, toupper(*end)) : NULL;
+    if (unit) {
+        for (int i = 0; i <= unit - units; i++) {
+            if (budget > LONG_MAX / MEM_UNIT) {
+                return -1;
+            }
+            budget *= MEM_UNIT;
+        }
+        end++;
+    }
+    return *end == '\0' && budget >= MIN_MEM ? budget : -1;
+}
+
+/**
+ * The over_budget function takes in the name of a dictionary and a memory
+ * budget in bytes. A loaded text dictionary takes several times the size
+ * of its file once every word's offset, length and letter counts are
+ * added, so it is over budget if DICT_MEM_FACTOR times its file is larger
+ * than the budget. A compiled index is mapped read only, so its pages can
+ * always be dropped and read again, and it is never over budget.
+ * Returns 1 if the dictionary should be streamed, and 0 otherwise.
+ */
+int over_budget(const char *dictName, long budget) {
+    struct stat info;
+    if (stat(dictName, &info) == -1 || !S_ISREG(info.st_mode) ||
+            is_index(dictName)) {
+        return 0;
+    }
+    return info.st_size > budget / DICT_MEM_FACTOR;
+}
+
+/**
+ * The read_chunk function takes in the open dictionary file, the memory
+ * budget, and the line buffer used to read it. Words are read into a new
+ * arena until it would fill its share of the budget. The share leaves room
+ * for the arena's arrays doubling as they grow, and for their old copies
+ * while they move. Returns the arena, or NULL once the file has been read.
+ */
+static Dict *read_chunk(FILE *dictFile, long budget, char **line,
+        size_t *lineSize) {
+    Dict *arena = NULL;
+    ssize_t length;
+    while ((length = getline(line, lineSize, dictFile)) >= 0) {
+        if (length && (*line)[length - 1] == '\n') {
+            length--;
+        }
+        if (!arena) {
+            arena = new_arena();
+        }
+        if (arena_add(arena, *line, length) < 0 ||
+                (long)(arena->poolSize + arena->wordCount * WORD_MEMORY) >
+                budget / CHUNK_MEM_SHARE) {
+            break;
+        }
+    }
+    return arena;
+}
+
+/**
+ * Takes in a dictionary and an array of word indices and its length, and
+ * writes the words to a new temporary file, one per line, which is removed
+ * once it is closed. Returns the file, or NULL if it could not be written.
+ */
+static FILE *spill_run(Dict *dict, const uint32_t *words, int wordCount) {
+    FILE *run = tmpfile();
+    if (!run) {
+        return NULL;
+    }
+    for (int i = 0; i < wordCount; i++) {
+        fwrite(dict_word(dict, words[i]), 1, dict->lengths[words[i]], run);
+        putc('\n', run);
+    }
+    if (fflush(run) != 0 || ferror(run)) {
+        fclose(run);
+        return NULL;
+    }
+    return run;
+}
+
+/**
+ * The stream_query function takes in the argument structs, the open
+ * dictionary file, the memory budget in bytes, the output stream and the
+ * query's stats (or NULL). It answers the query without loading the whole
+ * dictionary: the file is read in chunks that fit the budget, each chunk's
+ * matches are filtered and sorted in memory as usual and spilled to a
+ * temporary file as a sorted run, and the runs are then merged into the
+ * output. Timings and word counts are added to stats.
+ * Returns the number of words written, or -1 if the runs or the output
+ * could not be written.
+ */
+int stream_query(ArgType **argStructs, FILE *dictFile, long budget,
+        FILE *output, QueryStats *stats) {
+    Ranking ranking;
+    Merge merge;
+    merge.runs = NULL;
+    merge.runCount = 0;
+    merge.order = spec_order(argStructs[0]->data);
+    merge.ranking = argStructs[TOP_ARG]->data &&
+            query_ranking(argStructs, &ranking) == 0 ? &ranking : NULL;
+    merge.unique = 0;
+    long limit = merge.ranking ? merge.ranking->count : 0;
+    char *line = NULL;
+    size_t lineSize = 0;
+    int failed = 0;
+
+    double start = stats_clock();
+    Dict *chunk;
+    while (!failed && (chunk = read_chunk(dictFile, budget, &line,
+            &lineSize))) {
+        double read = stats_clock();
+        int wordCount = 0;
+        uint32_t *words = sort_normal(argStructs, chunk, &wordCount, stats);
+        double filtered = stats_clock();
+        wordCount = order_words(chunk, merge.order, words, wordCount, 0);
+        if (wordCount) {
+            merge.runs = (Run *) realloc(merge.runs, sizeof(Run) *
+                    (merge.runCount + 1));
+            merge.runs[merge.runCount].file = spill_run(chunk, words,
+                    wordCount);
+            failed = !merge.runs[merge.runCount].file;
+            merge.runCount += !failed;
+        }
+        free(words);
+        free_dict(chunk);
+        double spilled = stats_clock();
+        if (stats) {
+            stats->load += read - start;
+            stats->filter += filtered - read;
+            stats->sort += spilled - filtered;
+        }
+        start = spilled;
+    }
+    free(line);
+
+    long written = -1;
+    if (!failed && reduce_runs(&merge, limit) == 0) {
+        double merged = stats_clock();
+        if (argStructs[GROUPS_ARG]->data) {
+            written = merge_groups(argStructs, &merge, limit, output,
+                    stats);
+        } else {
+            written = merge_runs(&merge, limit, word_delimiter(argStructs),
+                    output);
+            if (stats && written > 0) {
+                stats->written += written;
+            }
+        }
+        if (stats) {
+            stats->output += stats_clock() - merged;
+        }
+    } else {
+        for (int i = 0; i < merge.runCount; i++) {
+            fclose(merge.runs[i].file);
+        }
+    }
+    free(merge.runs);
+    return written < 0 ? -1 : (int)written;
+}
@@ -0,0 +1,22 @@
+#ifndef _STREAM_H
+#define _STREAM_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "unjumble.h"
+
+// Macro Definitions
+#define MEM_UNIT 1024
+#define MIN_MEM (64 * MEM_UNIT)
+#define DICT_MEM_FACTOR 4
+#define CHUNK_MEM_SHARE 3
+#define WORD_MEMORY (sizeof(uint64_t) + sizeof(int) + \
+        2 * sizeof(uint32_t) + ALPHABET_SIZE)
+
+// Function Declarations
+long mem_check(const char *memArg);
+int over_budget(const char *dictName, long budget);
+int stream_query(ArgType **argStructs, FILE *dictFile, long budget,
+        FILE *output, QueryStats *stats);
+
+#endif
@@ -0,0 +1,179 @@
+/**
+ * Author: Ethan Pinto
+ * Student Number: s4642286
+ * Program Name: unjumble
+ * File Name: top.c
+**/
+
+#define _GNU_SOURCE
+#include "top.h"
+#include "sort.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * The read_scores function takes in the name of a scores file and the
+ * ranking to fill in. Each line of the file is a letter followed by its
+ * value, a whole number, such as "q 10". Letters that are not listed are
+ * worth nothing, and empty lines are skipped.
+ * Returns 0 on success, and -1 if the file cannot be opened or a line is
+ * not of that form.
+ */
+int read_scores(const char *fileName, Ranking *ranking) {
+    FILE *scoresFile = fopen(fileName, "r");
+    if (!scoresFile) {
+        return -1;
+    }
+    memset(ranking->values, 0, sizeof(ranking->values));
+    ranking->scored = 1;
+
+    char *line = NULL;
+    size_t lineCap = 0;
+    int status = 0;
+    while (status == 0 && getline(&line, &lineCap, scoresFile) >= 0) {
+        char letter[2];
+        int value, used = 0;
+        if (sscanf(line, " %n", &used) == 0 && line[used] == '\0') {
+            continue;
+        }
+        if (sscanf(line, " %1[A-Za-z] %d %n", letter, &value, &used) != 2 ||
+                line[used] != '\0' || value < 0) {
+            status = -1;
+        } else {
+            ranking->values[letter_index(letter[0])] = value;
+        }
+    }
+    free(line);
+    fclose(scoresFile);
+    return status;
+}
+
+/**
+ * Takes in a ranking and a null terminated word, and returns the total
+ * value of the word's letters, read from the word itself.
+ */
+long text_score(const Ranking *ranking, const char *word) {
+    long score = 0;
+    for (const char *letter = word; *letter; letter++) {
+        if (isalpha(*letter)) {
+            score += ranking->values[letter_index(*letter)];
+        }
+    }
+    return score;
+}
+
+/**
+ * Takes in a dictionary, a ranking and the index of a word, and returns
+ * the total value of the word's letters.
+ */
+static long word_score(const Dict *dict, const Ranking *ranking,
+        uint32_t word) {
+    long score = 0;
+    uint32_t mask = dict->masks[word];
+    if (mask & OVERFLOW_BIT) {
+        // The count columns saturate, so score the letters themselves.
+        return text_score(ranking, dict_word(dict, word));
+    }
+    for (uint32_t left = mask & LETTER_BITS; left; left &= left - 1) {
+        int letter = __builtin_ctz(left);
+        score += (long)ranking->values[letter] *
+                letter_count(dict, letter, word);
+    }
+    return score;
+}
+
+/**
+ * Takes in a dictionary, a ranking and the indices of two words.
+ * Returns a negative number if word1 ranks above word2, a positive number
+ * if it ranks below, and 0 if they are the same word.
+ */
+int rank_cmp(const Dict *dict, const Ranking *ranking, uint32_t word1,
+        uint32_t word2) {
+    if (ranking->scored) {
+        long score1 = word_score(dict, ranking, word1);
+        long score2 = word_score(dict, ranking, word2);
+        if (score1 != score2) {
+            return score1 > score2 ? -1 : 1;
+        }
+    }
+    return cmp_len(&word1, &word2, (void *)dict);
+}
+
+/**
+ * The comparison function used to put the kept words in rank order. It
+ * takes in two word indices and the dictionary and ranking to use.
+ */
+static int cmp_rank(const void *word1, const void *word2, void *context) {
+    const void **pair = (const void **)context;
+    return rank_cmp(pair[0], pair[1], *(const uint32_t *)word1,
+            *(const uint32_t *)word2);
+}
+
+/**
+ * Takes in a heap and its size, and the position of an entry that may
+ * rank above its children. Moves the entry down until the heap is
+ * ordered, with the lowest ranked word at the top. Returns nothing.
+ */
+static void sift_down(const Dict *dict, const Ranking *ranking,
+        uint32_t *heap, int heapSize, int position) {
+    while (1) {
+        int lowest = position;
+        for (int child = 2 * position + 1; child <= 2 * position + 2 &&
+                child < heapSize; child++) {
+            if (rank_cmp(dict, ranking, heap[child], heap[lowest]) > 0) {
+                lowest = child;
+            }
+        }
+        if (lowest == position) {
+            return;
+        }
+        uint32_t swap = heap[position];
+        heap[position] = heap[lowest];
+        heap[lowest] = swap;
+        position = lowest;
+    }
+}
+
+/**
+ * The heap_offer function takes in a dictionary, a ranking, a heap of at
+ * most ranking->count words with the lowest ranked at the top, its size,
+ * and a word. The word is added if the heap is not full, or replaces the
+ * top if it ranks above it, so the heap always holds the best words
+ * offered so far. Returns nothing.
+ */
+void heap_offer(const Dict *dict, const Ranking *ranking, uint32_t *heap,
+        int *heapSize, uint32_t word) {
+    if (*heapSize < ranking->count) {
+        // Move the new word up past every word that ranks above it.
+        int position = (*heapSize)++;
+        while (position > 0 && rank_cmp(dict, ranking, word,
+                heap[(position - 1) / 2]) > 0) {
+            heap[position] = heap[(position - 1) / 2];
+            position = (position - 1) / 2;
+        }
+        heap[position] = word;
+    } else if (rank_cmp(dict, ranking, word, heap[0]) < 0) {
+        heap[0] = word;
+        sift_down(dict, ranking, heap, *heapSize, 0);
+    }
+}
+
+/**
+ * The select_top function takes in a dictionary, a ranking and an array
+ * of word indices. The best ranking->count words are selected with a
+ * bounded heap in one pass and moved to the front of the array in rank
+ * order. Returns the number of words kept.
+ */
+int select_top(const Dict *dict, const Ranking *ranking, uint32_t *words,
+        int wordCount) {
+    int heapSize = 0;
+    for (int i = 0; i < wordCount; i++) {
+        // The heap is never longer than the words already read.
+        heap_offer(dict, ranking, words, &heapSize, words[i]);
+    }
+    const void *context[2] = {dict, ranking};
+    qsort_r(words, heapSize, sizeof(uint32_t), cmp_rank, context);
+    return heapSize;
+}
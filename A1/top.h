@@ -0,0 +1,28 @@
+#ifndef _TOP_H
+#define _TOP_H
+
+#include <stdint.h>
+#include "dict.h"
+
+// Macro Definitions
+#define MAX_TOP 1000000
+
+// The ranking of a -top query: by total letter value if a scores file was
+// given, then by length, longest first, then in -alpha order.
+typedef struct {
+    int count;                      // Number of words to keep
+    int scored;                     // True if letter values were given
+    int values[ALPHABET_SIZE];      // Value of each letter
+} Ranking;
+
+// Function Declarations
+int read_scores(const char *fileName, Ranking *ranking);
+long text_score(const Ranking *ranking, const char *word);
+int rank_cmp(const Dict *dict, const Ranking *ranking, uint32_t word1,
+        uint32_t word2);
+void heap_offer(const Dict *dict, const Ranking *ranking, uint32_t *heap,
+        int *heapSize, uint32_t word);
+int select_top(const Dict *dict, const Ranking *ranking, uint32_t *words,
+        int wordCount);
+
+#endif
@@ -0,0 +1,150 @@
+/**
+ * Author: Ethan Pinto
+ * Student Number: s4642286
+ * Program Name: unjumble
+ * File Name: union.c
+**/
+
+#include "union.h"
+#include "cache.h"
+#include "merge.h"
+#include "sort.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * The load_dicts function takes in an array to fill in, the names of the
+ * dictionaries and their number, and loads every dictionary. If one cannot
+ * be loaded, those loaded before it are freed.
+ * Returns -1 if they were all loaded, and otherwise the position of the
+ * first that could not be.
+ */
+int load_dicts(Dict **dicts, char **dictNames, int dictCount) {
+    for (int i = 0; i < dictCount; i++) {
+        dicts[i] = load_dict(dictNames[i]);
+        if (!dicts[i]) {
+            for (int j = 0; j < i; j++) {
+                free_dict(dicts[j]);
+            }
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Takes in a word set and a word. The word is added to the set unless it
+ * is already there. Returns 1 if the word was added, and 0 if it was in
+ * the set.
+ */
+static int set_add(WordSet *set, const char *word) {
+    size_t slot = hash_key(word) & set->slotMask;
+    while (set->slots[slot]) {
+        if (strcmp(set->slots[slot], word) == 0) {
+            return 0;
+        }
+        slot = (slot + 1) & set->slotMask;
+    }
+    set->slots[slot] = word;
+    return 1;
+}
+
+/**
+ * The drop_seen function takes in the dictionaries of a union, their
+ * matching words in dictionary order, and the number of matches of each.
+ * Every word that matched in an earlier dictionary, or earlier in the same
+ * one, is dropped, so each word is written once, where it first appears.
+ * Returns nothing.
+ */
+static void drop_seen(Dict **dicts, uint32_t **words, int *wordCounts,
+        int dictCount) {
+    size_t total = 0;
+    for (int d = 0; d < dictCount; d++) {
+        total += wordCounts[d];
+    }
+    WordSet set;
+    size_t slotCount = MIN_SET_SLOTS;
+    while (slotCount < total * 2) {
+        slotCount *= 2;
+    }
+    set.slots = (const char **) calloc(slotCount, sizeof(const char *));
+    set.slotMask = slotCount - 1;
+    for (int d = 0; d < dictCount; d++) {
+        int kept = 0;
+        for (int i = 0; i < wordCounts[d]; i++) {
+            if (set_add(&set, dict_word(dicts[d], words[d][i]))) {
+                words[d][kept++] = words[d][i];
+            }
+        }
+        wordCounts[d] = kept;
+    }
+    free(set.slots);
+}
+
+/**
+ * The union_query function takes in the argument structs, the loaded
+ * dictionaries and their number, the output stream and the query's stats
+ * (or NULL). It answers the query against the union of the dictionaries,
+ * writing each matching word once. Each dictionary's matches are
+ * filtered and put in order on their own, which costs nothing for a
+ * dictionary that is already sorted, and are then merged with a k-way
+ * merge rather than joined and sorted again. Timings and word counts are
+ * added to stats. Returns the number of words written, or -1 if they
+ * could not be written or the matches of a -groups query could not be
+ * spilled to be grouped.
+ */
+int union_query(ArgType **argStructs, Dict **dicts, int dictCount,
+        FILE *output, QueryStats *stats) {
+    Ranking ranking;
+    Merge merge;
+    merge.runs = (Run *) malloc(sizeof(Run) * dictCount);
+    merge.runCount = dictCount;
+    merge.order = spec_order(argStructs[0]->data);
+    merge.ranking = argStructs[TOP_ARG]->data &&
+            query_ranking(argStructs, &ranking) == 0 ? &ranking : NULL;
+    merge.unique = 1;
+    long limit = merge.ranking ? merge.ranking->count : 0;
+    uint32_t **words = (uint32_t **) malloc(sizeof(uint32_t *) * dictCount);
+    int *wordCounts = (int *) malloc(sizeof(int) * dictCount);
+
+    for (int d = 0; d < dictCount; d++) {
+        double start = stats_clock();
+        words[d] = sort_normal(argStructs, dicts[d], &wordCounts[d], stats);
+        double filtered = stats_clock();
+        wordCounts[d] = order_words(dicts[d], merge.order, words[d],
+                wordCounts[d], scan_order(argStructs, dicts[d]) != NULL);
+        if (stats) {
+            stats->filter += filtered - start;
+            stats->sort += stats_clock() - filtered;
+        }
+    }
+    // Equal words only end up next to each other when merged in order.
+    if (merge.order == ORDER_NONE && !merge.ranking) {
+        drop_seen(dicts, words, wordCounts, dictCount);
+    }
+    for (int d = 0; d < dictCount; d++) {
+        memory_run(&merge.runs[d], dicts[d], words[d], wordCounts[d]);
+    }
+
+    long written;
+    double start = stats_clock();
+    if (argStructs[GROUPS_ARG]->data) {
+        written = merge_groups(argStructs, &merge, limit, output, stats);
+    } else {
+        written = merge_runs(&merge, limit, word_delimiter(argStructs),
+                output);
+        if (stats && written > 0) {
+            stats->written += written;
+        }
+    }
+    if (stats) {
+        stats->output += stats_clock() - start;
+    }
+    for (int d = 0; d < dictCount; d++) {
+        free(words[d]);
+    }
+    free(words);
+    free(wordCounts);
+    free(merge.runs);
+    return (int)written;
+}
@@ -0,0 +1,23 @@
+#ifndef _UNION_H
+#define _UNION_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "unjumble.h"
+
+// Macro Definitions
+#define MIN_SET_SLOTS 16
+
+// The words already kept from earlier dictionaries, for a union whose
+// words are left in dictionary order and so cannot be merged.
+typedef struct {
+    const char **slots;     // Kept words by hash, NULL for an empty slot
+    size_t slotMask;        // Number of slots, a power of two, less one
+} WordSet;
+
+// Function Declarations
+int load_dicts(Dict **dicts, char **dictNames, int dictCount);
+int union_query(ArgType **argStructs, Dict **dicts, int dictCount,
+        FILE *output, QueryStats *stats);
+
+#endif
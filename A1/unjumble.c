@@ -1,10 +1,25 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <ctype.h>
 #include <string.h>
-#define ARG_NUM 4
-#define NULL_T_SIZE 1
-#define MAX_WORD_LEN 50
+#include <sys/stat.h>
+#include "unjumble.h"
+#include "batch.h"
+#include "cache.h"
+#include "dawg.h"
+#include "dict.h"
+#include "filter.h"
+#include "graph.h"
+#include "group.h"
+#include "index.h"
+#include "output.h"
+#include "pattern.h"
+#include "phrase.h"
+#include "serve.h"
+#include "stream.h"
+#include "union.h"
+#include "sort.h"
 
 /**
  * Author: Ethan Pinto
@@ -12,34 +27,31 @@
  * Course Code: CSSE2310
  */
 
-/* The arguments provided in the command line. */
-typedef struct {
-    int index;
-    char *data;
-} ArgType;
-
 /**
  * This function creates the structs for the command line arguments.
  * Returns an array of pointers pointing to each struct.
  * Throughout the program, each argument is represented as follows:
  * argStructs[0] = specifier, argStructs[1] = single letter
- * argStructs[2] = letters, argStructs[3] = dictionary file
+ * argStructs[2] = letters, argStructs[3] = first dictionary file
+ * argStructs[THREADS_ARG] = number of filter threads
+ * argStructs[NULL_ARG] = set if words end with a null character
+ * argStructs[PATTERN_ARG] = pattern of letters and blanks to match
+ * argStructs[TOP_ARG] = number of best words to return
+ * argStructs[SCORES_ARG] = file of letter values to rank words by
+ * argStructs[GROUPS_ARG] = set if words are grouped by anagram class
+ * argStructs[STATS_ARG] = set if timings and word counts are reported
+ * argStructs[CACHE_ARG] = directory query output is cached in
+ * argStructs[MEM_ARG] = memory budget the dictionary must fit in
  */
 ArgType **create_structs(void) {
     ArgType **argStructs = (ArgType **) malloc(sizeof(ArgType *) * ARG_NUM);
 
     // Fill array with pointers to structs containing info about each argument.
-    argStructs[0] = (ArgType *) malloc(sizeof(ArgType)); // specifier
-    argStructs[1] = (ArgType *) malloc(sizeof(ArgType)); // single letter
-    argStructs[2] = (ArgType *) malloc(sizeof(ArgType)); // letters
-    argStructs[3] = (ArgType *) malloc(sizeof(ArgType)); // dictionary file
-
     // Set the value of each argument to be NULL initially.
-    argStructs[0]->data = NULL;
-    argStructs[1]->data = NULL;
-    argStructs[2]->data = NULL;
-    argStructs[3]->data = NULL;
-    
+    for (int i = 0; i < ARG_NUM; i++) {
+        argStructs[i] = (ArgType *) malloc(sizeof(ArgType));
+        argStructs[i]->data = NULL;
+    }
     return argStructs;
 }
 
@@ -63,14 +75,15 @@ void free_structs(ArgType **argStructs) {
 /**
  * Handles all the cases that arise through errors in command line
  * argument inputs. It is one of the main exit pathways for the program.
+ * The other exit codes are 5 when a file can not be written, 6 when the
+ * server can not listen on its socket, and 10 when no words are found.
  * It takes in an exit code and the array of argument structs.
  * Returns nothing.
  */
 void err_check(int exitcode, ArgType **argStructs) {
     switch (exitcode) {
         case 1: // Invalid command line inputs.
-            fprintf(stderr, "Usage: unjumble [-alpha|-len|-longest]" 
-                    " [-include letter] letters [dictionary]\n");
+            fprintf(stderr, USAGE_MESSAGE);
             free_structs(argStructs);
             exit(1);
 
@@ -81,16 +94,21 @@ void err_check(int exitcode, ArgType **argStructs) {
             exit(2);
 
         case 3: // Less than 3 characters in letters argument.
-            fprintf(stderr, "unjumble: must supply at least three letters\n");
+            fprintf(stderr, FEW_LETTERS_MESSAGE);
             free_structs(argStructs);       
             exit(3);
 
         case 4: // Letters are not all alphabetical.
-            fprintf(stderr, "unjumble: can only unjumble alphabetic "
-                    "characters\n");
+            fprintf(stderr, NON_ALPHA_MESSAGE);
             free_structs(argStructs);           
             exit(4);
 
+        case 7: // Scores file cannot be read or is not valid.
+            fprintf(stderr, "unjumble: scores file \"%s\" can not be "
+                    "read\n", argStructs[SCORES_ARG]->data);
+            free_structs(argStructs);
+            exit(7);
+
         default:
             return;
     }
@@ -132,6 +150,9 @@ int *find_optional(int argc, char **argv, ArgType **argStructs) {
         FILE *dictFile = fopen(argv[i], "r");
         if (argv[i][0] == '-') {
             indexList[i] = 0;
+        } else if (option_value(argStructs, i)) {
+            // Argument is the value of an option.
+            indexList[i] = 0;
         } else if (strlen(argv[i]) == 1) {
             // Check if argument is the single letter after '-include'
             if (argStructs[1]->data) {
@@ -151,38 +172,114 @@ int *find_optional(int argc, char **argv, ArgType **argStructs) {
 }
 
 /**
- * Identifies the dictionary input, check if is a valid file, and stores
- * the value if it is. Returns an exitcode 2 if the file is invalid,
- * returns an exitcode 1 if there are arguments after the filename, 
- * and returns 0 if no errors were encountered.
+ * Takes in the command line arguments, the argument structs after the
+ * specifiers have been found, and the index of an argument. Returns 1 if
+ * the argument can be a dictionary, because it is not an option, the
+ * value of one, or the -include letter, and 0 otherwise.
+ */
+int dict_arg(char **argv, ArgType **argStructs, int index) {
+    return argv[index][0] != '-' && !option_value(argStructs, index) &&
+            !(argStructs[1]->data && argStructs[1]->index == index);
+}
+
+/**
+ * Takes in the command line arguments and the argument structs after the
+ * specifiers have been found, and counts the dictionaries at the end of
+ * the command line beyond the first: the arguments there that can be
+ * dictionaries and name files that can be opened. The letters are never
+ * the name of a file. Returns the number of extra dictionaries.
+ */
+int extra_dicts(int argc, char **argv, ArgType **argStructs) {
+    int dictCount = 0;
+    for (int i = argc - 1; i > 0 && dict_arg(argv, argStructs, i); i--) {
+        FILE *dictFile = fopen(argv[i], "r");
+        if (!dictFile) {
+            break;
+        }
+        fclose(dictFile);
+        dictCount++;
+    }
+    return dictCount > 1 ? dictCount - 1 : 0;
+}
+
+/**
+ * Takes in the command line arguments and the argument structs, with the
+ * first dictionary at the index stored for it. Checks that every
+ * dictionary from there to the last argument can be opened, and stores
+ * the first that cannot. Returns an exitcode 2 if one cannot be opened,
+ * and 0 otherwise.
+ */
+int open_dicts(int argc, char **argv, ArgType **argStructs) {
+    for (int i = argStructs[3]->index; i < argc; i++) {
+        FILE *dictFile = fopen(argv[i], "r");
+        if (!dictFile) {
+            free(argStructs[3]->data);
+            argStructs[3]->data = strdup(argv[i]);
+            return 2;
+        }
+        fclose(dictFile);
+    }
+    return 0;
+}
+
+/**
+ * Identifies the dictionary inputs of a pattern or -groups query given
+ * without the letters argument, which are the arguments at the end that
+ * do not belong to an option. Stores the first dictionary, or the default
+ * dictionary if there is none. Returns an exitcode 2 if a file is
+ * invalid, and 0 otherwise.
+ */
+int pattern_dict(int argc, char **argv, ArgType **argStructs) {
+    int first = argc;
+    while (first > 1 && dict_arg(argv, argStructs, first - 1)) {
+        first--;
+    }
+    argStructs[3]->index = 0;
+    if (first == argc) {
+        argStructs[3]->data = strdup(DEFAULT_DICT);
+        return 0;
+    }
+    argStructs[3]->index = first;
+    argStructs[3]->data = strdup(argv[first]);
+    return open_dicts(argc, argv, argStructs);
+}
+
+/**
+ * Identifies the dictionary inputs, which are every argument after the
+ * letters, checks they are valid files, and stores the first of them.
+ * Returns an exitcode 2 if a file is invalid, returns an exitcode 1 if an
+ * option follows the letters, and returns 0 if no errors were encountered.
  */
 int is_dict(int argc, char **argv, ArgType **argStructs) {
-    argStructs[3]->data = (char *) malloc(strlen("/usr/share/dict/words")
-            + NULL_T_SIZE);
+    if (!argStructs[2]->data) {
+        return pattern_dict(argc, argv, argStructs);
+    }
+    argStructs[3]->index = 0;
 
     // Check if the letters argument is the last argument.
     if (argStructs[2]->index == argc - 1) {
         // No dictionary file was input. Set dictionary to default values.
-        strcpy(argStructs[3]->data, "/usr/share/dict/words");
-
-    } else if (argStructs[2]->index < argc) {
-        FILE *dictFile = fopen(argv[argStructs[2]->index + 1], "r");
-        argStructs[3]->index = argStructs[2]->index + 1;
-        argStructs[3]->data = (char *)realloc(argStructs[3]->data,
-                strlen(argv[argStructs[3]->index])
-                + NULL_T_SIZE);
-        strcpy(argStructs[3]->data, argv[argStructs[3]->index]);
-
-        if (argStructs[3]->index != argc - 1) {
-            // Dictionary argument is not last argument.
+        argStructs[3]->data = strdup(DEFAULT_DICT);
+        return 0;
+    }
+    argStructs[3]->index = argStructs[2]->index + 1;
+    argStructs[3]->data = strdup(argv[argStructs[3]->index]);
+    for (int i = argStructs[3]->index; i < argc; i++) {
+        if (!dict_arg(argv, argStructs, i)) {
+            // An option follows the dictionaries.
             return 1;
-        } else if (dictFile == NULL) { 
-            return 2;
-        } else {
-            fclose(dictFile);
         }
     }
-    return 0;
+    return open_dicts(argc, argv, argStructs);
+}
+
+/**
+ * Takes in the number of command line arguments and the argument structs
+ * after the dictionaries have been found. Returns the number of
+ * dictionaries the query is run against.
+ */
+int dict_count(int argc, ArgType **argStructs) {
+    return argStructs[3]->index ? argc - argStructs[3]->index : 1;
 }
 
 /**
@@ -201,10 +298,12 @@ int is_letters(int argc, char **argv, ArgType **argStructs) {
             letterNum++;
         }
     } 
-    // Check if letters argument is not present, if so, return 1.
+    // Check if letters argument is not present, if so, return 1 unless a
+    // pattern or -groups was given, which need no letters.
     if (letterNum == 0) {
         free(indexList);
-        return 1;
+        return argStructs[PATTERN_ARG]->data ||
+                argStructs[GROUPS_ARG]->data ? 0 : 1;
     } 
 
     argStructs[2]->data = (char *) malloc(sizeof(char));
@@ -215,7 +314,7 @@ int is_letters(int argc, char **argv, ArgType **argStructs) {
             if (strlen(argv[i]) < 3) {
                 free(indexList);
                 return 3;
-            } else if (alpha_check(argv[i]) == -1) {
+            } else if (letters_check(argv[i]) == -1) {
                 free(indexList);
                 return 4;
             } else {
@@ -233,14 +332,94 @@ int is_letters(int argc, char **argv, ArgType **argStructs) {
     return 0;
 }
 
+/**
+ * Takes in the argument following "-threads" and checks that it is a
+ * whole number of threads between 1 and MAX_THREADS.
+ * Returns 1 if it is valid and -1 otherwise.
+ */
+int thread_check(char *threadArg) {
+    char *end;
+    long threads = strtol(threadArg, &end, 10);
+    if (!isdigit(threadArg[0]) || *end != '\0' || threads < 1 ||
+            threads > MAX_THREADS) {
+        return -1;
+    }
+    return 1;
+}
+
+/**
+ * Takes in the argument following "-top" and checks that it is a whole
+ * number of words between 1 and MAX_TOP.
+ * Returns 1 if it is valid and -1 otherwise.
+ */
+int top_check(char *topArg) {
+    char *end;
+    long top = strtol(topArg, &end, 10);
+    if (!isdigit(topArg[0]) || *end != '\0' || top < 1 || top > MAX_TOP) {
+        return -1;
+    }
+    return 1;
+}
+
+/**
+ * Takes in the argument structs after the specifiers have been found and
+ * returns how many arguments were used by options beyond the original
+ * specifier and -include options.
+ */
+int option_args(ArgType **argStructs) {
+    return (argStructs[THREADS_ARG]->data ? 2 : 0) +
+            (argStructs[NULL_ARG]->data ? 1 : 0) +
+            (argStructs[PATTERN_ARG]->data ? 2 : 0) +
+            (argStructs[TOP_ARG]->data ? 2 : 0) +
+            (argStructs[SCORES_ARG]->data ? 2 : 0) +
+            (argStructs[GROUPS_ARG]->data ? 1 : 0) +
+            (argStructs[STATS_ARG]->data ? 1 : 0) +
+            (argStructs[CACHE_ARG]->data ? 2 : 0) +
+            (argStructs[MEM_ARG]->data ? 2 : 0);
+}
+
+/**
+ * Takes in the argument structs after the specifiers have been found and
+ * the index of an argument. Returns 1 if the argument is the value of the
+ * -threads, -pattern, -top, -scores, -cache or -mem option, and 0
+ * otherwise.
+ */
+int option_value(ArgType **argStructs, int index) {
+    int options[] = {THREADS_ARG, PATTERN_ARG, TOP_ARG, SCORES_ARG,
+            CACHE_ARG, MEM_ARG};
+    for (int i = 0; i < sizeof(options) / sizeof(int); i++) {
+        if (argStructs[options[i]]->data &&
+                argStructs[options[i]]->index == index) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Takes in the argument structs and returns the character each output word
+ * ends with: a null character if -null was given, and a newline otherwise.
+ */
+char word_delimiter(ArgType **argStructs) {
+    return argStructs[NULL_ARG]->data ? '\0' : '\n';
+}
+
 /**
  * Finds the index and type of specifier in the command line arguments
  * if there is one present. Also identifies if -include is present as
- * well as if it is followed by a valid single letter.
+ * well as if it is followed by a valid single letter, and if -threads is
+ * present and followed by a valid thread count, if -null is present, if
+ * -pattern is present and followed by a valid pattern, and if -top and
+ * -scores are present and followed by a word count and a file name, and if
+ * -groups and -stats are present, and if -cache and -mem are present and
+ * followed by a directory and a memory budget. A -top query is ranked
+ * instead of sorted, so it cannot have a specifier.
  * Returns 0 if no errors occurred, and 1 for a usage error.
  */
 int is_spec(int argc, char **argv, ArgType **argStructs) {
-    int specNum = 0, incNum = 0;
+    int specNum = 0, incNum = 0, threadNum = 0, nullNum = 0, patternNum = 0;
+    int topNum = 0, scoresNum = 0, groupsNum = 0, statsNum = 0;
+    int cacheNum = 0, memNum = 0;
     argStructs[0]->data = (char *) malloc(sizeof(char) + NULL_T_SIZE);
     argStructs[1]->data = (char *) malloc(sizeof(char) + NULL_T_SIZE);
    
@@ -257,21 +436,102 @@ int is_spec(int argc, char **argv, ArgType **argStructs) {
         } else if (strcmp(argv[i], "-include") == 0) {
             incNum++;
             // Check if the argument following '-include' is a single letter.
-            if (strlen(argv[i + 1]) == 1 && isalpha(*argv[i + 1]) != 0) {
+            if (i + 1 < argc && strlen(argv[i + 1]) == 1 &&
+                    isalpha(*argv[i + 1]) != 0) {
                 // Get the index and value of the single letter.
                 argStructs[1]->index = i + 1;
                 strcpy(argStructs[1]->data, argv[i + 1]);
             } else {
                 return 1;
             }
+        } else if (strcmp(argv[i], "-threads") == 0) {
+            threadNum++;
+            // Check if the argument following '-threads' is a thread count.
+            if (i + 1 < argc && thread_check(argv[i + 1]) == 1) {
+                argStructs[THREADS_ARG]->index = i + 1;
+                free(argStructs[THREADS_ARG]->data);
+                argStructs[THREADS_ARG]->data = strdup(argv[i + 1]);
+            } else {
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-pattern") == 0) {
+            patternNum++;
+            // Check if the argument following '-pattern' is a pattern.
+            if (i + 1 < argc && pattern_check(argv[i + 1]) == 1) {
+                argStructs[PATTERN_ARG]->index = i + 1;
+                free(argStructs[PATTERN_ARG]->data);
+                argStructs[PATTERN_ARG]->data = strdup(argv[i + 1]);
+            } else {
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-top") == 0) {
+            topNum++;
+            // Check if the argument following '-top' is a word count.
+            if (i + 1 < argc && top_check(argv[i + 1]) == 1) {
+                argStructs[TOP_ARG]->index = i + 1;
+                free(argStructs[TOP_ARG]->data);
+                argStructs[TOP_ARG]->data = strdup(argv[i + 1]);
+            } else {
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-scores") == 0) {
+            scoresNum++;
+            // The file itself is read once the query is run.
+            if (i + 1 < argc) {
+                argStructs[SCORES_ARG]->index = i + 1;
+                free(argStructs[SCORES_ARG]->data);
+                argStructs[SCORES_ARG]->data = strdup(argv[i + 1]);
+            } else {
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-cache") == 0) {
+            cacheNum++;
+            // The directory is only used if it can be written to.
+            if (i + 1 < argc) {
+                argStructs[CACHE_ARG]->index = i + 1;
+                free(argStructs[CACHE_ARG]->data);
+                argStructs[CACHE_ARG]->data = strdup(argv[i + 1]);
+            } else {
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-mem") == 0) {
+            memNum++;
+            // Check if the argument following '-mem' is a memory budget.
+            if (i + 1 < argc && mem_check(argv[i + 1]) > 0) {
+                argStructs[MEM_ARG]->index = i + 1;
+                free(argStructs[MEM_ARG]->data);
+                argStructs[MEM_ARG]->data = strdup(argv[i + 1]);
+            } else {
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-groups") == 0) {
+            groupsNum++;
+            argStructs[GROUPS_ARG]->index = i;
+            free(argStructs[GROUPS_ARG]->data);
+            argStructs[GROUPS_ARG]->data = strdup(argv[i]);
+        } else if (strcmp(argv[i], "-stats") == 0) {
+            statsNum++;
+            argStructs[STATS_ARG]->index = i;
+            free(argStructs[STATS_ARG]->data);
+            argStructs[STATS_ARG]->data = strdup(argv[i]);
+        } else if (strcmp(argv[i], "-null") == 0) {
+            nullNum++;
+            argStructs[NULL_ARG]->index = i;
+            free(argStructs[NULL_ARG]->data);
+            argStructs[NULL_ARG]->data = strdup(argv[i]);
         } else if (argv[i][0] == '-') {
             // There are other arguments that start with '-' but are invalid.
             return 1;
         }
     }
-    if (specNum > 1 || incNum > 1) {
+    if (specNum > 1 || incNum > 1 || threadNum > 1 || nullNum > 1 ||
+            patternNum > 1 || topNum > 1 || scoresNum > 1 || groupsNum > 1 ||
+            statsNum > 1 || cacheNum > 1 || memNum > 1) {
         // More than one specifier is present in the command line.
         return 1;
+    } else if ((topNum && specNum) || scoresNum > topNum) {
+        // Words are either ranked by -top or sorted by a specifier.
+        return 1;
     } else if (specNum == 0 && incNum == 0) {
         // Free memory and clear argument data.
         free(argStructs[0]->data);
@@ -288,217 +548,415 @@ int is_spec(int argc, char **argv, ArgType **argStructs) {
     return 0;
 }
 
-/* SORTING FUNCTIONS */
+/**
+ * The parse_request function takes in one query line (sent to the server
+ * or read from a batch file) and a fresh set of argument structs. A line
+ * has the same form as the command line without the dictionary: letters
+ * [-include letter] [-alpha|-len|-longest] [-threads count] [-null]
+ * [-pattern pattern] [-top count [-scores file]] [-groups], in any order.
+ * The letters may be left out of a pattern or -groups query. -stats
+ * reports to the command line's standard error, -cache names a directory
+ * for the command line's output, and -mem decides how the command line
+ * loads its dictionary, so a query line cannot ask for any of them. The
+ * line is split in place.
+ * Returns 0 if the query is valid, or the exit code the command line would
+ * have used (1, 3, 4 or 7) if it is not.
+ */
+int parse_request(char *line, ArgType **argStructs) {
+    char *args[MAX_QUERY_ARGS + 1];
+    int argCount = 0;
+    char *savePtr;
+
+    // Split the line into arguments, leaving args[0] as the program name.
+    args[argCount++] = "unjumble";
+    for (char *token = strtok_r(line, QUERY_DELIMS, &savePtr); token;
+            token = strtok_r(NULL, QUERY_DELIMS, &savePtr)) {
+        if (argCount == MAX_QUERY_ARGS + 1) {
+            return 1;
+        }
+        args[argCount++] = token;
+    }
+
+    int status = is_spec(argCount, args, argStructs);
+    if (status || argStructs[STATS_ARG]->data ||
+            argStructs[CACHE_ARG]->data || argStructs[MEM_ARG]->data) {
+        return 1;
+    }
+    // The letters are the only argument that is not an option.
+    for (int i = 1; i < argCount; i++) {
+        if (args[i][0] == '-' ||
+                (argStructs[1]->data && argStructs[1]->index == i) ||
+                option_value(argStructs, i)) {
+            continue;
+        } else if (argStructs[2]->data) {
+            return 1;
+        }
+        argStructs[2]->index = i;
+        argStructs[2]->data = strdup(args[i]);
+    }
+
+    if (!argStructs[2]->data) {
+        status = argStructs[PATTERN_ARG]->data ||
+                argStructs[GROUPS_ARG]->data ? 0 : 1;
+    } else if (strlen(argStructs[2]->data) < 3) {
+        status = 3;
+    } else if (letters_check(argStructs[2]->data) == -1) {
+        status = 4;
+    }
+    if (status == 0) {
+        // Check the scores file can be read before the query is run.
+        Ranking ranking;
+        status = query_ranking(argStructs, &ranking);
+    }
+    return status;
+}
 
 /**
- * Counts the number of words in a dictionary file.
- * Returns an integer corresponding to the word count.
- */ 
-int count_words(ArgType **argStructs) {
-    FILE *dictFile = fopen(argStructs[3]->data, "r");
-    int wordCount = 0;
-    char temp[MAX_WORD_LEN];
-    
-    // Calculate number of words in dictionary file.
-    while (fgets(temp, MAX_WORD_LEN, dictFile) != NULL) {
-        wordCount++;
+ * Takes in the status returned by parse_request and a stream, and writes
+ * the message the command line would have printed for that error.
+ * Returns nothing.
+ */
+void write_request_error(int status, FILE *output) {
+    if (status == 3) {
+        fprintf(output, FEW_LETTERS_MESSAGE);
+    } else if (status == 4) {
+        fprintf(output, NON_ALPHA_MESSAGE);
+    } else if (status == 7) {
+        fprintf(output, SCORES_MESSAGE);
+    } else {
+        fprintf(output, USAGE_MESSAGE);
     }
-    fclose(dictFile);
-    return wordCount;
 }
 
 /**
- * Reads a dictionary file and returns an array of all the words
- * contained in the dictionary file.
- * Note: If no dictionary file was input into the command line, the
- * default dictionary file is read.
- */ 
-char **get_words(ArgType **argStructs) {
-    FILE *dictFile = fopen(argStructs[3]->data, "r");
-    int wordCount = count_words(argStructs);
+ * Takes in the argument structs and the ranking to fill in. The ranking
+ * keeps the number of words given to -top (0 if there is no -top option),
+ * and the letter values read from the -scores file if one was given.
+ * Returns 0 on success, and 7 if the scores file cannot be read.
+ */
+int query_ranking(ArgType **argStructs, Ranking *ranking) {
+    ranking->count = argStructs[TOP_ARG]->data ?
+            atoi(argStructs[TOP_ARG]->data) : 0;
+    ranking->scored = 0;
+    if (argStructs[SCORES_ARG]->data &&
+            read_scores(argStructs[SCORES_ARG]->data, ranking) == -1) {
+        return 7;
+    }
+    return 0;
+}
 
-    // Create an array to hold all words provided in dictionary file.
-    char **wordList = (char **) malloc(sizeof(char *) * wordCount);
-    // Create a temporary array to store each word.
-    char word[MAX_WORD_LEN];
+/**
+ * Takes in the argument structs, the dictionary and an array of matching
+ * word indices. If -top was given, the best words are moved to the front
+ * of the array in rank order. Returns the number of words kept.
+ */
+int rank_words(ArgType **argStructs, Dict *dict, uint32_t *words,
+        int wordCount) {
+    Ranking ranking;
+    if (!argStructs[TOP_ARG]->data ||
+            query_ranking(argStructs, &ranking) != 0) {
+        return wordCount;
+    }
+    return select_top(dict, &ranking, words, wordCount);
+}
 
-    // Allocate memory to each pointer and store words in array.
-    for (int i = 0; i < wordCount; i++) {
-        fgets(word, MAX_WORD_LEN, dictFile);
-        word[strlen(word) - 1] = '\0';
-        wordList[i] = (char *) malloc(strlen(word) + NULL_T_SIZE);
-        strcpy(wordList[i], word);
+/* SORTING FUNCTIONS */
+
+/**
+ * Takes in the argument structs and the loaded dictionary. If the
+ * dictionary is a compiled index that already holds the ordering needed by
+ * the specifier, that ordering is returned so words can be scanned in
+ * output order. Returns NULL if the words must be sorted after filtering.
+ */
+const uint32_t *scan_order(ArgType **argStructs, Dict *dict) {
+    if (!argStructs[0]->data || argStructs[PATTERN_ARG]->data) {
+        return NULL;
+    } else if (strcmp(argStructs[0]->data, "-alpha") == 0) {
+        return dict->alphaOrder;
     }
-    fclose(dictFile);
-    return wordList;
+    // Both -len and -longest start from the descending length order.
+    return dict->lenOrder;
 }
 
 /**
- * Takes in the argStructs array and a pointer to a string and compares
- * each letter in the string to each letter in the letters argument.
- * Returns 1 if all letters in the word match a letter in the letters argument
- * and returns -1 if some letters do not match.
+ * Takes in the argument structs and the loaded dictionary, and filters
+ * the dictionary words based on if they can be made with the letters
+ * provided in the letters argument. Words are scanned in presorted order
+ * when the dictionary provides one, and split across threads if -threads
+ * was given. For a -top query only the best words are kept, in rank order.
+ * A -groups query without letters keeps every word of the dictionary.
+ * The words looked at and rejected are counted in stats, if it is not
+ * NULL. Returns an array of the indices of the matching words, compacted
+ * in place. The words themselves stay in the dictionary's pool.
  */ 
-int has_all_letters(ArgType **argStructs, char *word) {
-    int matchingLetters = 0;
-
-    char *lettersCopy = (char *)malloc(strlen(argStructs[2]->data) +
-            NULL_T_SIZE);
-    strcpy(lettersCopy, argStructs[2]->data);
-
-    // Iterate through the word and letters argument and match letters.
-    for (int j = 0; j < strlen(word); j++) {
-        char letter1 = (char)toupper((int)word[j]);
-        for (int i = 0; i < strlen(lettersCopy); i++) {
-            if (lettersCopy[i] != '-') {
-                char letter2 = (char)toupper((int)lettersCopy[i]);
-                if (letter1 == letter2) {
-                    matchingLetters++;
-                    // Remove letter as it has already been used.
-                    lettersCopy[i] = '-'; 
-                    break;
-                }
-            }
-        }
+uint32_t *sort_normal(ArgType **argStructs, Dict *dict, int *numWords,
+        QueryStats *stats) {
+    uint32_t *sortedWords = (uint32_t *) malloc(sizeof(uint32_t) *
+            (dict->wordCount ? dict->wordCount : 1));
+
+    // Build the letter histogram of the letters argument once.
+    Query query;
+    prepare_query(&query, argStructs[2]->data, argStructs[1]->data);
+    query.longest = argStructs[0]->data &&
+            strcmp(argStructs[0]->data, "-longest") == 0;
+    query.stats = stats;
+    Ranking ranking;
+    if (argStructs[TOP_ARG]->data &&
+            query_ranking(argStructs, &ranking) == 0) {
+        query.ranking = &ranking;
+    }
+    int threads = 1;
+    if (argStructs[THREADS_ARG]->data) {
+        threads = atoi(argStructs[THREADS_ARG]->data);
     }
-    free(lettersCopy);
 
-    if (strlen(word) == matchingLetters) {
-        return 1;
+    // Sort through dictionary words and filter in matching words.
+    if (argStructs[PATTERN_ARG]->data) {
+        *numWords = pattern_words(dict, argStructs[PATTERN_ARG]->data, &query,
+                sortedWords);
+    } else if (!argStructs[2]->data) {
+        *numWords = all_words(dict, &query, scan_order(argStructs, dict),
+                sortedWords);
     } else {
-        return -1;
+        *numWords = filter_words(dict, &query, scan_order(argStructs, dict),
+                threads, sortedWords);
+        return sortedWords;
     }
+    // Only the filter selects the best words as it goes.
+    if (query.ranking) {
+        *numWords = select_top(dict, query.ranking, sortedWords, *numWords);
+    }
+    return sortedWords;
 }
 
 /**
- * This function takes in two char *, letter and word, and returns 1
- * if the word contains the specified letter. It returns -1 otherwise.
- */ 
-int has_single_letter(char *letter, char *word) {
-    char singleLetter = (char)toupper((int)letter[0]);
-    for (int j = 0; j < strlen(word); j++) {
-        char wordLetter = (char)toupper((int)word[j]);
-        if (singleLetter == wordLetter) {
-            return 1;
-        }
+ * Takes in the specifier (or NULL) and returns the order it asks for.
+ */
+int spec_order(char *spec) {
+    if (!spec) {
+        return ORDER_NONE;
+    } else if (strcmp(spec, "-alpha") == 0) {
+        return ORDER_ALPHA;
+    } else if (strcmp(spec, "-len") == 0) {
+        return ORDER_LEN;
     }
-    return -1;
+    return ORDER_LONGEST;
 }
 
 /**
- * Takes in array of string pointers which point to dictionary words.
- * Sorts them based on if they can be made with the letters provided
- * in the letters argument.
- * Returns an array of sorted words.
- */ 
-char **sort_normal(ArgType **argStructs, int *numWords) {
-    int numberWords = 0;
-    // Get the list of dictionary words.
-    char **wordList = get_words(argStructs);
-    int wordCount = count_words(argStructs);
+ * Takes in the argument structs, the dictionary, an array of matching
+ * word indices and its length, whether the words are already in the
+ * specifier's order, and the output stream. The words are sorted according
+ * to the specifier (if there is one) and written to the output stream by
+ * write_output. The time spent sorting and writing is recorded in stats,
+ * if it is not NULL. Returns the number of words written, or -1 if they
+ * could not be written.
+ */
+int output_words(ArgType **argStructs, Dict *dict, uint32_t *sortedWords,
+        int wordCount, int presorted, FILE *output, QueryStats *stats) {
+    // Sort the dictionary words according to the specifier provided.
+    double start = stats_clock();
+    wordCount = order_words(dict, spec_order(argStructs[0]->data),
+            sortedWords, wordCount, presorted);
+    if (stats) {
+        stats->sort += stats_clock() - start;
+    }
+    return write_output(argStructs, dict, sortedWords, wordCount, output,
+            stats);
+}
 
-    // Sort through dictionary words and filter in matching words.
-    for (int i = 0; i < wordCount; i++) {
-        if (strlen(wordList[i]) > strlen(argStructs[2]->data) ||
-                strlen(wordList[i]) < 3 ||
-                has_all_letters(argStructs, wordList[i]) == -1) { 
-            free(wordList[i]);
-            wordList[i] = NULL;
-        }
-        // Remove all words that don't contain the single letter (if present)
-        if (argStructs[1]->data && wordList[i]) {
-            if (has_single_letter(argStructs[1]->data, wordList[i]) == -1) {
-                free(wordList[i]);
-                wordList[i] = NULL;
-            }
+/**
+ * Takes in the argument structs, the dictionary, an array of matching
+ * word indices in output order and its length, and the output stream. The
+ * words are written to the output stream in bulk, each followed by the
+ * -null or newline delimiter. For a -groups query each anagram class is
+ * written on one line instead, and the classes are in the order of their
+ * first words. The time spent writing is recorded in stats, if it is not
+ * NULL. Returns the number of words written, or -1 if they could not be
+ * written.
+ */
+int write_output(ArgType **argStructs, Dict *dict, uint32_t *sortedWords,
+        int wordCount, FILE *output, QueryStats *stats) {
+    double start = stats_clock();
+    int failed;
+    if (argStructs[GROUPS_ARG]->data) {
+        int *groupStarts = (int *) malloc(sizeof(int) * (wordCount + 1));
+        int groupCount = group_words(dict, sortedWords, wordCount,
+                groupStarts);
+        failed = write_groups(dict, sortedWords, groupStarts, groupCount,
+                word_delimiter(argStructs), output);
+        free(groupStarts);
+    } else {
+        failed = write_words(dict, sortedWords, wordCount,
+                word_delimiter(argStructs), output);
+    }
+    if (stats) {
+        stats->output += stats_clock() - start;
+        stats->written += wordCount;
+    }
+    return failed ? -1 : wordCount;
+}
+
+/**
+ * The query_key function takes in the argument structs of a query and
+ * returns the key its results are cached under, which the caller frees.
+ * The letters are case folded and sorted, so queries that differ only in
+ * the order or case of their letters share one key. They are followed by
+ * the -include letter, specifier, pattern and -top count, which also
+ * decide the results. Returns NULL if the results cannot be cached,
+ * because they are ranked by a -scores file that may change.
+ */
+char *query_key(ArgType **argStructs) {
+    if (argStructs[SCORES_ARG]->data) {
+        return NULL;
+    }
+    char *fields[] = {argStructs[2]->data, argStructs[1]->data,
+            argStructs[0]->data, argStructs[PATTERN_ARG]->data,
+            argStructs[TOP_ARG]->data};
+    int fieldCount = sizeof(fields) / sizeof(char *);
+    size_t length = fieldCount;
+    for (int i = 0; i < fieldCount; i++) {
+        length += fields[i] ? strlen(fields[i]) : 0;
+    }
+    char *key = (char *) malloc(length + NULL_T_SIZE);
+    char *end = key;
+    for (int i = 0; i < fieldCount; i++) {
+        for (int j = 0; fields[i] && fields[i][j]; j++) {
+            *end++ = tolower(fields[i][j]);
         }
+        *end++ = KEY_SEPARATOR;
     }
-    
-    char **sortedWords = (char **) malloc(sizeof(char *) * wordCount);
-    // Transfer all words into a new array containing only words.
-    int wordIndex = 0;
-    for (int k = 0; k < wordCount; k++) {
-        if (wordList[k]) {
-            sortedWords[wordIndex] = (char *) malloc(strlen(wordList[k]) +
-                    NULL_T_SIZE);
-            strcpy(sortedWords[wordIndex], wordList[k]);
-            free(wordList[k]);
-            numberWords++;
-            wordIndex++;
+    *end = '\0';
+    // Sort the letters, which come first, by insertion.
+    int lettersLen = fields[0] ? strlen(fields[0]) : 0;
+    for (int i = 1; i < lettersLen; i++) {
+        char letter = key[i];
+        int j = i;
+        for (; j > 0 && key[j - 1] > letter; j--) {
+            key[j] = key[j - 1];
         }
+        key[j] = letter;
     }
-    // Free the list of words provided by the get_words function.
-    free(wordList);
-    *numWords = numberWords;
-    return sortedWords;
+    return key;
 }
 
 /**
- * The comparison function for the "-alpha" argument. It is used to sort
- * the array of dictionary words in lexicographical order.
- * Returns 1 if word1 should go after word2.
- * Returns -1 if word1 should go before word2
- * Returns 0 if the words are the same alphabetically.
+ * Runs the query described by the argument structs against a loaded
+ * dictionary. Matching words are sorted according to the specifier and
+ * written to the output stream, one per line. If the dictionary keeps a
+ * cache, the sorted words are taken from it when the same letters have
+ * been queried before, and added to it otherwise. Timings and word counts
+ * are added to stats, unless it is NULL.
+ * Returns the number of words written, or -1 if they could not be written.
  */
-int cmp_alpha(const void *word1, const void *word2) {
-    int result = strcasecmp(*(const char **)word1, *(const char **)word2);
-    // Check the return value of strcasecmp function.
-    if (result == 0) {
-        int compareValue = strcmp(*(const char **)word1,
-                *(const char **)word2);
-        if (compareValue > 0) {
-            return 1;
-        } else if (compareValue < 0) {
-            return -1;
-        } else {
-            return 0;
+int run_query(ArgType **argStructs, Dict *dict, FILE *output,
+        QueryStats *stats) {
+    char *key = dict->cache ? query_key(argStructs) : NULL;
+    int wordCount = 0;
+    uint32_t *sortedWords = key ? cache_find(dict->cache, key, &wordCount) :
+            NULL;
+    if (!sortedWords) {
+        double start = stats_clock();
+        sortedWords = sort_normal(argStructs, dict, &wordCount, stats);
+        double filtered = stats_clock();
+        wordCount = order_words(dict, spec_order(argStructs[0]->data),
+                sortedWords, wordCount, scan_order(argStructs, dict) != NULL);
+        if (stats) {
+            stats->filter += filtered - start;
+            stats->sort += stats_clock() - filtered;
         }
-    } 
-    return result;
+        if (key) {
+            cache_store(dict->cache, key, sortedWords, wordCount);
+        }
+    }
+    free(key);
+    int printed = write_output(argStructs, dict, sortedWords, wordCount,
+            output, stats);
+    free(sortedWords);
+    return printed;
 }
 
 /**
- * The comparison function for the "-len" argument. It is used to sort
- * the array of dictionary words in descending length.
- * Returns 1 if word1 is shorter than word2.
- * Returns -1 if word1 is longest than word2.
- * Returns result of cmp_alpha if the words are the same length.
- */ 
-int cmp_len(const void *word1, const void *word2) {
-    // Compare the length of each word.
-    if (strlen(*(const char **)word1) > strlen(*(const char **)word2)) {
-        return -1; // word 1 is longer than word 2.
-    } else if (strlen(*(const char **)word1) < strlen(*(const char **)word2)) {
-        return 1; // word 1 is shorter than word 2.
-    } 
-    return cmp_alpha(word1, word2);
+ * The disk_key function takes in the argument structs of a command line
+ * query, and the names of its dictionaries and their number. It returns
+ * the key the query's output is cached under in the -cache directory,
+ * which the caller frees. It extends the query's key with the -groups and
+ * -null flags, which change the output, and with the device, inode, size
+ * and modification time of each dictionary, so output is never reused once
+ * a dictionary changes. Returns NULL if the output cannot be cached.
+ */
+char *disk_key(ArgType **argStructs, char **dictNames, int dictCount) {
+    char *key = query_key(argStructs);
+    char *diskKey = NULL;
+    if (!key || asprintf(&diskKey, "%s%c%c", key,
+            argStructs[GROUPS_ARG]->data ? 'g' : '-',
+            argStructs[NULL_ARG]->data ? 'n' : '-') == -1) {
+        free(key);
+        return NULL;
+    }
+    free(key);
+    for (int i = 0; i < dictCount && diskKey; i++) {
+        struct stat info;
+        key = diskKey;
+        if (stat(dictNames[i], &info) == -1 || asprintf(&diskKey,
+                "%s%c%llx:%llx:%llx:%llx.%09ld", key, KEY_SEPARATOR,
+                (unsigned long long)info.st_dev,
+                (unsigned long long)info.st_ino,
+                (unsigned long long)info.st_size,
+                (unsigned long long)info.st_mtim.tv_sec,
+                info.st_mtim.tv_nsec) == -1) {
+            diskKey = NULL;
+        }
+        free(key);
+    }
+    return diskKey;
 }
 
 /**
- * Finds the largest word/s in the dictionary using the cmp_len function
- * and removes any words that are shorter than this word length.
- * Returns nothing.
- */ 
-void cmp_longest(char **sortedWords, int wordCount) {
-    qsort(sortedWords, wordCount, sizeof(const char *), cmp_len);
-    int maxLength = 0;
-    
-    // Find the length of the longest word in the sorted words list.
-    for (int i = 0; i < wordCount; i++) {
-        if (sortedWords[i]) {
-            maxLength = strlen(sortedWords[i]);
-            break;
-        }
+ * Handles "unjumble -compile dictionary index", which compiles a text
+ * dictionary into a binary index that later queries can map directly.
+ * It takes in the command line arguments and the argument structs, and
+ * exits with 0 on success, 1 on a usage error, 2 if the dictionary cannot
+ * be opened, and 5 if the index cannot be written.
+ */
+void compile_mode(int argc, char **argv, ArgType **argStructs) {
+    if (argc != 4) {
+        fprintf(stderr, "Usage: unjumble -compile dictionary index\n");
+        free_structs(argStructs);
+        exit(1);
     }
-    // Remove all words that have a length smaller than maxLength.
-    for (int j = 0; j < wordCount; j++) {
-        if (sortedWords[j]) {
-            if (strlen(sortedWords[j]) < maxLength) {
-                free(sortedWords[j]);
-                sortedWords[j] = NULL;
-            }
-        }
+    argStructs[3]->data = strdup(argv[2]);
+
+    int status = compile_index(argv[2], argv[3]);
+    err_check(status, argStructs);
+    if (status == 5) {
+        fprintf(stderr, "unjumble: index \"%s\" can not be written\n",
+                argv[3]);
+        free_structs(argStructs);
+        exit(5);
     }
+    free_structs(argStructs);
+    exit(0);
+}
+
+/**
+ * Takes in the argument structs, whichever of a DAWG, a dictionary file to
+ * stream within the -mem budget, or loaded dictionaries the query is to be
+ * answered from, the output stream and the query's stats (or NULL), and
+ * runs the query against it.
+ * Returns the number of words written, or -1 if they could not be written.
+ */
+static int answer_query(ArgType **argStructs, Dawg *dawg, FILE *dictFile,
+        long budget, Dict **dicts, int dictCount, FILE *output,
+        QueryStats *stats) {
+    if (dawg) {
+        return dawg_query(argStructs, dawg, output, stats);
+    } else if (dictFile) {
+        return stream_query(argStructs, dictFile, budget, output, stats);
+    } else if (dictCount > 1) {
+        return union_query(argStructs, dicts, dictCount, output, stats);
+    }
+    return run_query(argStructs, dicts[0], output, stats);
 }
 
 /**
@@ -510,46 +968,174 @@ int main(int argc, char **argv) {
     // Create the structs for the command line arguments.
     ArgType **argStructs = create_structs();
 
+    // Compile a dictionary index instead of running a query.
+    if (argc > 1 && strcmp(argv[1], "-compile") == 0) {
+        compile_mode(argc, argv, argStructs);
+    }
+
+    // Build a DAWG instead of running a query.
+    if (argc > 1 && strcmp(argv[1], "-dawg") == 0) {
+        dawg_mode(argc, argv, argStructs);
+    }
+
+    // Write the sub-anagram graph of a whole dictionary.
+    if (argc > 1 && strcmp(argv[1], "-graph") == 0) {
+        graph_mode(argc, argv, argStructs);
+    }
+
+    // Find multi-word anagrams instead of single words.
+    if (argc > 1 && strcmp(argv[1], "-phrase") == 0) {
+        phrase_mode(argc, argv, argStructs);
+    }
+
+    // Serve queries over a socket instead of running a single query.
+    if (argc > 1 && strcmp(argv[1], "-serve") == 0) {
+        serve_mode(argc, argv, argStructs);
+    }
+
+    // Answer a file of queries with a single pass over the dictionary.
+    if (argc > 1 && strcmp(argv[1], "-batch") == 0) {
+        batch_mode(argc, argv, argStructs);
+    }
+
     // Check number of inputs.
-    if (argc < 2 || argc > 6) {
+    if (argc < 2) {
         err_check(1, argStructs);
     }
 
     // Check for errors encountered while finding and storing required values.
     err_check(is_spec(argc, argv, argStructs), argStructs);
+    if (argc - option_args(argStructs) - extra_dicts(argc, argv, argStructs)
+            > MAX_CMD_ARGS) {
+        err_check(1, argStructs);
+    }
     err_check(is_letters(argc, argv, argStructs), argStructs);
     err_check(is_dict(argc, argv, argStructs), argStructs); 
+    Ranking ranking;
+    err_check(query_ranking(argStructs, &ranking), argStructs);
 
-    // Calculate number of words to be printed.
-    int actualWordCount = 0;
-    char **sortedWords = sort_normal(argStructs, &actualWordCount);
+    // Time the query and count its words if -stats was given.
+    QueryStats queryStats;
+    memset(&queryStats, 0, sizeof(QueryStats));
+    QueryStats *stats = argStructs[STATS_ARG]->data ? &queryStats : NULL;
 
-    if (actualWordCount == 0) {
-        exit(10);
+    // Several dictionaries are answered as one union. Each is loaded
+    // whole, so a DAWG or a -mem budget only applies to a single one.
+    int dictCount = dict_count(argc, argStructs);
+    char **dictNames = dictCount > 1 ? argv + argStructs[3]->index :
+            &argStructs[3]->data;
+    for (int i = 0; i < dictCount && dictCount > 1; i++) {
+        if (argStructs[MEM_ARG]->data || is_dawg(dictNames[i])) {
+            err_check(1, argStructs);
+        }
     }
 
-    // Sort the dictionary words according to the specifier provided.
-    if (argStructs[0]->data) {
-        if (strcmp(argStructs[0]->data, "-alpha") == 0) {
-            qsort(sortedWords, actualWordCount, sizeof(const char *),
-                    cmp_alpha);
+    // A streamed -groups query merges its matches back into memory to
+    // group them, so without letters to limit the matches it would hold
+    // the whole dictionary, whatever the -mem budget.
+    if (argStructs[MEM_ARG]->data && argStructs[GROUPS_ARG]->data &&
+            !argStructs[2]->data) {
+        err_check(1, argStructs);
+    }
 
-        } else if (strcmp(argStructs[0]->data, "-len") == 0) {
-            qsort(sortedWords, actualWordCount, sizeof(const char *), cmp_len);
+    // Search a DAWG generatively instead of filtering every word. A DAWG
+    // holds no positional bitmaps, so it cannot answer pattern queries,
+    // and it can only be searched from letters.
+    int dawgQuery = is_dawg(argStructs[3]->data);
+    if (dawgQuery && (argStructs[PATTERN_ARG]->data || !argStructs[2]->data)) {
+        err_check(1, argStructs);
+    }
 
-        } else if (strcmp(argStructs[0]->data, "-longest") == 0) {
-            cmp_longest(sortedWords, actualWordCount);
+    // Copy the output of a query run before from the -cache directory. A
+    // -stats query is always run, so there is something to report.
+    char *cacheDir = argStructs[CACHE_ARG]->data;
+    char *diskKey = cacheDir && !stats ?
+            disk_key(argStructs, dictNames, dictCount) : NULL;
+    if (diskKey) {
+        long copied = cache_read(cacheDir, diskKey, stdout);
+        if (copied == CACHE_WRITE_FAILED) {
+            fprintf(stderr, WRITE_MESSAGE);
+            free(diskKey);
+            free_structs(argStructs);
+            exit(5);
+        } else if (copied >= 0) {
+            free(diskKey);
+            free_structs(argStructs);
+            exit(copied ? 0 : 10);
         }
     }
-    // Print words to standard output.
-    for (int i = 0; i < actualWordCount; i++) {
-        if (sortedWords[i]) {
-            printf("%s\n", sortedWords[i]);
-            free(sortedWords[i]);
+
+    // Map the dictionaries or DAWG into memory, unless the dictionary is
+    // too large for the -mem budget, in which case it is streamed instead.
+    double start = stats_clock();
+    long budget = argStructs[MEM_ARG]->data ?
+            mem_check(argStructs[MEM_ARG]->data) : 0;
+    Dawg *dawg = NULL;
+    Dict **dicts = (Dict **) calloc(dictCount, sizeof(Dict *));
+    FILE *dictFile = NULL;
+    int failed = -1;
+    if (dawgQuery) {
+        dawg = load_dawg(argStructs[3]->data);
+        failed = dawg ? -1 : 0;
+    } else if (budget && over_budget(argStructs[3]->data, budget)) {
+        dictFile = fopen(argStructs[3]->data, "r");
+        failed = dictFile ? -1 : 0;
+    } else {
+        failed = load_dicts(dicts, dictNames, dictCount);
+    }
+    if (failed >= 0) {
+        // Name the dictionary that could not be loaded.
+        char *dictName = strdup(dictNames[failed]);
+        free(argStructs[3]->data);
+        argStructs[3]->data = dictName;
+        free(dicts);
+        free(diskKey);
+        err_check(2, argStructs);
+    }
+    queryStats.load = stats_clock() - start;
+
+    // Write the output to a new cache file first if it is to be cached.
+    char *tempName = NULL;
+    FILE *capture = diskKey ? cache_create(cacheDir, diskKey, &tempName) :
+            NULL;
+    int printed = answer_query(argStructs, dawg, dictFile, budget, dicts,
+            dictCount, capture ? capture : stdout, stats);
+    if (capture && printed >= 0) {
+        if (cache_commit(capture, tempName, cacheDir, diskKey, stdout) < 0) {
+            printed = -1;
+        }
+    } else if (capture) {
+        // Nothing is cached if the cache file could not be written in full,
+        // but the query is still answered.
+        cache_abandon(capture, tempName);
+        if (dictFile) {
+            rewind(dictFile);
         }
+        printed = answer_query(argStructs, dawg, dictFile, budget, dicts,
+                dictCount, stdout, stats);
+    }
+    if (dictFile) {
+        fclose(dictFile);
+    }
+    free(diskKey);
+    free_dawg(dawg);
+    for (int i = 0; i < dictCount; i++) {
+        free_dict(dicts[i]);
+    }
+    free(dicts);
+    if (printed < 0) {
+        // The words could not be written, or streaming or grouping a union
+        // could not spill them to temporary files.
+        fprintf(stderr, WRITE_MESSAGE);
+        free_structs(argStructs);
+        exit(5);
+    }
+
+    // Exit with 10 if no words were found.
+    if (stats) {
+        write_stats(stats, stderr);
     }
-    free(sortedWords);
     free_structs(argStructs);
-    exit(0);
+    exit(printed ? 0 : 10);
     return 0;
 }
@@ -0,0 +1,68 @@
+#ifndef _UNJUMBLE_H
+#define _UNJUMBLE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "dict.h"
+#include "stats.h"
+#include "top.h"
+
+// Macro Definitions
+#define ARG_NUM 13
+#define THREADS_ARG 4
+#define NULL_ARG 5
+#define PATTERN_ARG 6
+#define TOP_ARG 7
+#define SCORES_ARG 8
+#define GROUPS_ARG 9
+#define STATS_ARG 10
+#define CACHE_ARG 11
+#define MEM_ARG 12
+#define KEY_SEPARATOR '|'
+#define MAX_CMD_ARGS 6
+#define MAX_QUERY_ARGS 15
+#define QUERY_DELIMS " \t\r\n"
+#define NULL_T_SIZE 1
+#define DEFAULT_DICT "/usr/share/dict/words"
+#define USAGE_MESSAGE "Usage: unjumble [-alpha|-len|-longest]" \
+        " [-include letter] letters [dictionary]\n"
+#define FEW_LETTERS_MESSAGE "unjumble: must supply at least three letters\n"
+#define NON_ALPHA_MESSAGE "unjumble: can only unjumble alphabetic " \
+        "characters\n"
+#define WRITE_MESSAGE "unjumble: output can not be written\n"
+#define SCORES_MESSAGE "unjumble: scores file can not be read\n"
+
+/* The arguments provided in the command line. */
+typedef struct {
+    int index;
+    char *data;
+} ArgType;
+
+// Function Declarations
+ArgType **create_structs(void);
+void free_structs(ArgType **argStructs);
+void err_check(int exitcode, ArgType **argStructs);
+int alpha_check(char *letterTest);
+int thread_check(char *threadArg);
+int is_spec(int argc, char **argv, ArgType **argStructs);
+int option_args(ArgType **argStructs);
+int option_value(ArgType **argStructs, int index);
+int query_ranking(ArgType **argStructs, Ranking *ranking);
+int rank_words(ArgType **argStructs, Dict *dict, uint32_t *words,
+        int wordCount);
+int parse_request(char *line, ArgType **argStructs);
+void write_request_error(int status, FILE *output);
+char word_delimiter(ArgType **argStructs);
+const uint32_t *scan_order(ArgType **argStructs, Dict *dict);
+uint32_t *sort_normal(ArgType **argStructs, Dict *dict, int *numWords,
+        QueryStats *stats);
+int spec_order(char *spec);
+char *query_key(ArgType **argStructs);
+int output_words(ArgType **argStructs, Dict *dict, uint32_t *sortedWords,
+        int wordCount, int presorted, FILE *output, QueryStats *stats);
+int write_output(ArgType **argStructs, Dict *dict, uint32_t *sortedWords,
+        int wordCount, FILE *output, QueryStats *stats);
+int run_query(ArgType **argStructs, Dict *dict, FILE *output,
+        QueryStats *stats);
+
+#endif